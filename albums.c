@@ -2,41 +2,79 @@
 #include <stdlib.h>
 #include <dirent.h>
 #include <string.h>
+#include <stddef.h>
 #include <strings.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "include/albums.h"
 #include "include/songs.h"
 #include "include/utils.h"
+#include "include/textmatch.h"
+#include "include/persist.h"
+#include "include/posindex.h"
+
+#define ALBUMS_DIR "utils/albums/"
+#define ALBUMS_DB_PATH "utils/albums.db"
+#define ALBUMS_DB_MAGIC "CUAD"
+#define ALBUMS_DB_VERSION 1
+#define ALBUM_SLOT_LIVE 1u
+#define ALBUM_STORE_MIN_SLOTS 16
+
+/* utils/albums.db holds every album in one file:
+ *   [AlbumStoreHeader][AlbumSlot x slot_capacity][heap]
+ * Each live slot points at its name and at an int32 array of song ids in the
+ * heap. A track array is allocated with spare capacity so most edits rewrite
+ * it in place followed by its 40-byte slot; an album that outgrows its array
+ * gets a new one at the end of the heap. Dead slots and abandoned arrays are
+ * reclaimed when the store is rewritten, which also happens when the
+ * directory is full. Slots are loaded in order and albums are prepended, so
+ * the newest album (highest slot) is listed first, as within a session. */
+typedef struct AlbumStoreHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_capacity;
+    uint64_t heap_end;
+    uint64_t heap_garbage;
+} AlbumStoreHeader;
+
+typedef struct AlbumSlot {
+    int32_t album_id;
+    uint32_t flags;
+    uint32_t name_len;
+    uint32_t track_count;
+    uint32_t track_capacity;
+    uint32_t reserved;
+    uint64_t name_off;
+    uint64_t tracks_off;
+} AlbumSlot;
 
 Album *g_albums = NULL;
 int g_next_album_id = 1;
 
+/* Serial numbers of g_albums, as shown by LIST ALBUMS. */
+static PositionIndex g_album_positions;
+static unsigned long g_albums_generation = 0;
+
+static int g_album_store_fd = -1;
+/* Set when an unreadable albums.db could not be moved aside, so it is never
+ * overwritten. */
+static int g_album_store_disabled = 0;
+static AlbumStoreHeader g_album_store;
+
 int iequals(const char *a, const char *b) {
     if (!a || !b) return 0;
-    return strcasecmp(a, b) == 0;
-}
-
-static Song* find_song_in_library_by_index(int index) {
-    if (index < 1) return NULL;
-    int idx = 1;
-    for (Song *s = g_songs; s; s = s->next) {
-        if (idx == index) return s;
-        idx++;
-    }
-    return NULL;
+    return ascii_casecmp_eq(a, b);
 }
 
-static AlbumNode* album_node_at_index(Album *a, int index, AlbumNode **prev_out) {
-    if (!a || index < 1) return NULL;
-    AlbumNode *prev = NULL;
-    AlbumNode *cur = a->head;
-    int idx = 1;
-    while (cur && idx < index) {
-        prev = cur;
-        cur = cur->next;
-        idx++;
-    }
-    if (prev_out) *prev_out = prev;
-    return cur;
+// Slot of the 1-based album position, or -1 if out of range
+static int album_track_at(Album *a, int index) {
+    if (!a || index < 1 || index > a->track_count) return -1;
+    return index - 1;
 }
 
 Album** find_all_albums_by_name(const char *name, int *count) {
@@ -62,6 +100,12 @@ Album** find_all_albums_by_name(const char *name, int *count) {
     return matches;
 }
 
+Album* find_album_by_number(int number) {
+    if (number <= 0) return NULL;
+    return position_index_at(&g_album_positions, g_albums_generation,
+                             g_albums, offsetof(Album, next), number);
+}
+
 Album* find_album_by_id(int id) {
     for (Album *a = g_albums; a; a = a->next) {
         if (a->album_id == id) {
@@ -84,13 +128,10 @@ Album* find_album_interactive(const char *input) {
 
     if (is_number_album(input)) {
         int choice = atoi(input);
-        int index = 1;
-
-        for (Album *a = g_albums; a; a = a->next, index++) {
-            if (index == choice) {
-                printf("Selected album: %s\n", a->name);
-                return a;
-            }
+        Album *a = find_album_by_number(choice);
+        if (a) {
+            printf("Selected album: %s\n", a->name);
+            return a;
         }
 
         printf("No album at position %d\n", choice);
@@ -110,11 +151,16 @@ Album* find_album_interactive(const char *input) {
         return result;
     }
 
+    if (g_batch_mode) {
+        Album *result = matches[0];
+        free(matches);
+        printf("Multiple albums found with name '%s', using the first listed\n", input);
+        return result;
+    }
+
     printf("\nMultiple albums found with name '%s':\n", input);
     for (int i = 0; i < count; i++) {
-        int song_count = 0;
-        for (AlbumNode *n = matches[i]->head; n; n = n->next) song_count++;
-        printf("%d. %s (%d songs)\n", i + 1, matches[i]->name, song_count);
+        printf("%d. %s (%d songs)\n", i + 1, matches[i]->name, matches[i]->track_count);
     }
 
     printf("Enter number (1-%d): ", count);
@@ -144,40 +190,57 @@ Album* create_album_internal(const char *name) {
     }
     
     a->album_id = g_next_album_id++;
-    a->head = NULL;
+    a->store_slot = -1;
+    a->dirty = 0;
+    a->tracks = NULL;
+    a->track_count = 0;
+    a->track_capacity = 0;
+    a->total_seconds = 0;
     a->next = g_albums;
     a->prev = NULL;
     
     if (g_albums) g_albums->prev = a;
     g_albums = a;
+    position_index_push(&g_album_positions, &g_albums_generation, a);
     
     return a;
 }
 
-AlbumNode* album_find_node(Album *a, const char *title, AlbumNode **prev_out) {
-    if (!a || !title) return NULL;
-    AlbumNode *prev = NULL;
-    for (AlbumNode *n = a->head; n; prev = n, n = n->next) {
-        if (n->song && n->song->title && iequals(n->song->title, title)) {
-            if (prev_out) *prev_out = prev;
-            return n;
+// Slot of the first track with the given title (case-insensitive), or -1
+int album_find_track(Album *a, const char *title) {
+    if (!a || !title) return -1;
+    char *folded = ascii_fold_dup(title);
+    if (!folded) return -1;
+    size_t len = strlen(folded);
+
+    for (int i = 0; i < a->track_count; i++) {
+        Song *s = a->tracks[i];
+        if (s->title && strlen(s->title) == len && ascii_equals_folded(s->title, len, folded)) {
+            free(folded);
+            return i;
         }
     }
-    return NULL;
+    free(folded);
+    return -1;
+}
+
+int album_reserve(Album *a, int capacity) {
+    if (capacity <= a->track_capacity) return 0;
+    Song **tracks = realloc(a->tracks, capacity * sizeof(Song*));
+    if (!tracks) return -1;
+    a->tracks = tracks;
+    a->track_capacity = capacity;
+    return 0;
 }
 
 int album_append_song(Album *a, Song *s) {
     if (!a || !s) return -1;
-    AlbumNode *node = (AlbumNode*)malloc(sizeof(AlbumNode));
-    if (!node) return -1;
-    node->song = s;
-    node->next = NULL;
-    if (!a->head) a->head = node;
-    else {
-        AlbumNode *tail = a->head;
-        while (tail->next) tail = tail->next;
-        tail->next = node;
+    if (a->track_count == a->track_capacity &&
+        album_reserve(a, a->track_capacity ? a->track_capacity * 2 : 8) != 0) {
+        return -1;
     }
+    a->tracks[a->track_count++] = s;
+    a->total_seconds += length_to_seconds(&s->length);
     return 0;
 }
 
@@ -192,33 +255,410 @@ int load_album_from_bin_by_id(int album_id, Album **out) {
     return -1;
 }
 
-int save_album_to_bin(const Album *a) {
-    if (!a || !a->name) return -1;
-    char filepath[512];
-    snprintf(filepath, sizeof(filepath), "utils/albums/%s_%d.bin", a->name, a->album_id);
-    FILE *fp = fopen(filepath, "wb");
+static off_t album_slot_offset(uint32_t slot) {
+    return (off_t)sizeof(AlbumStoreHeader) + (off_t)slot * sizeof(AlbumSlot);
+}
+
+static int pwrite_all(int fd, const void *buf, size_t len, off_t off) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = pwrite(fd, p, len, off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        off += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int32_t* album_track_ids(const Album *a) {
+    int32_t *ids = malloc((a->track_count ? a->track_count : 1) * sizeof(int32_t));
+    if (!ids) return NULL;
+    for (int i = 0; i < a->track_count; i++) ids[i] = a->tracks[i]->song_id;
+    return ids;
+}
+
+static uint32_t album_track_capacity(int count) {
+    return (uint32_t)(count + count / 2 + 4);
+}
+
+static int album_store_write_header() {
+    return pwrite_all(g_album_store_fd, &g_album_store, sizeof(g_album_store), 0);
+}
+
+/* Writes g_albums, oldest album first, to tmp_path, ready to be renamed
+ * over albums.db. The new header is returned in *hdr_out. */
+static int album_store_write(const char *tmp_path, AlbumStoreHeader *hdr_out) {
+    Album *oldest = NULL;
+    uint32_t count = 0;
+    for (Album *a = g_albums; a; a = a->next) {
+        oldest = a;
+        count++;
+    }
+
+    AlbumStoreHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, ALBUMS_DB_MAGIC, 4);
+    hdr.version = ALBUMS_DB_VERSION;
+    hdr.slot_count = count;
+    hdr.slot_capacity = count * 2 > ALBUM_STORE_MIN_SLOTS ? count * 2 : ALBUM_STORE_MIN_SLOTS;
+    uint64_t heap = (uint64_t)album_slot_offset(hdr.slot_capacity);
+
+    FILE *fp = fopen(tmp_path, "wb");
     if (!fp) {
-        perror("Failed to create album file");
+        perror("Failed to open albums.db for writing");
+        return -1;
+    }
+
+    uint64_t pos = heap;
+    uint32_t slot = 0;
+    int ok = fseek(fp, (long)sizeof(hdr), SEEK_SET) == 0;
+    for (Album *a = oldest; a; a = a->prev, slot++) {
+        AlbumSlot e;
+        memset(&e, 0, sizeof(e));
+        e.album_id = a->album_id;
+        e.flags = ALBUM_SLOT_LIVE;
+        e.name_len = (uint32_t)strlen(a->name);
+        e.track_count = (uint32_t)a->track_count;
+        e.track_capacity = album_track_capacity(a->track_count);
+        e.name_off = pos;
+        pos += e.name_len;
+        e.tracks_off = pos;
+        pos += (uint64_t)e.track_capacity * sizeof(int32_t);
+        fwrite(&e, sizeof(e), 1, fp);
+    }
+
+    if (fseek(fp, (long)heap, SEEK_SET) != 0) ok = 0;
+    for (Album *a = oldest; a && ok; a = a->prev) {
+        fwrite(a->name, 1, strlen(a->name), fp);
+        int32_t *ids = album_track_ids(a);
+        if (ids) fwrite(ids, sizeof(int32_t), a->track_count, fp);
+        else ok = 0;
+        free(ids);
+        uint32_t spare = album_track_capacity(a->track_count) - (uint32_t)a->track_count;
+        int32_t zero = 0;
+        for (uint32_t i = 0; i < spare; i++) fwrite(&zero, sizeof(zero), 1, fp);
+    }
+
+    hdr.heap_end = pos;
+    if (fseek(fp, 0, SEEK_SET) != 0) ok = 0;
+    fwrite(&hdr, sizeof(hdr), 1, fp);
+
+    /* A short fwrite only sets the stream error, so check it before the
+     * temp file can replace the store. The seeks leave nothing written past
+     * the live slots when the heap is empty, so extend the file to heap_end
+     * or the loader would reject it as truncated. */
+    if (!ok || ferror(fp) || fflush(fp) != 0 ||
+        ftruncate(fileno(fp), (off_t)pos) != 0 || fsync(fileno(fp)) != 0) {
+        perror("Failed to write albums.db");
+        fclose(fp);
+        remove(tmp_path);
+        return -1;
+    }
+    if (fclose(fp) != 0) {
+        perror("Failed to write albums.db");
+        remove(tmp_path);
+        return -1;
+    }
+    *hdr_out = hdr;
+    return 0;
+}
+
+static int album_store_replace(const char *tmp_path) {
+    if (rename(tmp_path, ALBUMS_DB_PATH) != 0) {
+        perror("Failed to replace albums.db");
+        remove(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+/* Rewrites the whole store from g_albums, dropping dead slots and
+ * unreferenced heap space, and renumbers store_slot to match. */
+static int album_store_rewrite() {
+    AlbumStoreHeader hdr;
+    if (album_store_write(ALBUMS_DB_PATH ".tmp", &hdr) != 0 ||
+        album_store_replace(ALBUMS_DB_PATH ".tmp") != 0) {
+        return -1;
+    }
+
+    int fd = open(ALBUMS_DB_PATH, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        perror("Failed to open albums.db");
+        return -1;
+    }
+    if (g_album_store_fd >= 0) close(g_album_store_fd);
+    g_album_store_fd = fd;
+    g_album_store = hdr;
+
+    Album *oldest = g_albums;
+    while (oldest && oldest->next) oldest = oldest->next;
+    uint32_t slot = 0;
+    for (Album *a = oldest; a; a = a->prev) a->store_slot = (int)slot++;
+    return 0;
+}
+
+/* Run in the background save child: writes the albums as of the fork to a
+ * snapshot file, which album_store_commit_snapshot then renames over
+ * albums.db or album_store_discard_snapshot removes. */
+int album_store_snapshot() {
+    if (g_album_store_disabled) return 0;
+    AlbumStoreHeader hdr;
+    return album_store_write(ALBUMS_DB_PATH ".snapshot", &hdr);
+}
+
+int album_store_commit_snapshot() {
+    if (g_album_store_disabled) return 0;
+    return album_store_replace(ALBUMS_DB_PATH ".snapshot");
+}
+
+void album_store_discard_snapshot() {
+    remove(ALBUMS_DB_PATH ".snapshot");
+}
+
+static int compare_album_ids(const void *a, const void *b) {
+    int x = (*(Album * const *)a)->album_id;
+    int y = (*(Album * const *)b)->album_id;
+    return (x > y) - (x < y);
+}
+
+/* Reopens albums.db after a background save may have replaced it and maps
+ * slots back to albums by id. Albums created since the fork are marked dirty
+ * so they get a slot; slots of albums deleted since are marked dead. */
+int album_store_reopen() {
+    if (g_album_store_disabled) return -1;
+    int fd = open(ALBUMS_DB_PATH, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        perror("Failed to open albums.db");
+        return -1;
+    }
+    AlbumStoreHeader hdr;
+    if (pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr) ||
+        memcmp(hdr.magic, ALBUMS_DB_MAGIC, 4) != 0 || hdr.slot_count > hdr.slot_capacity) {
+        close(fd);
+        return -1;
+    }
+    AlbumSlot *slots = malloc((hdr.slot_count ? hdr.slot_count : 1) * sizeof(AlbumSlot));
+    if (!slots) {
+        close(fd);
+        return -1;
+    }
+    size_t slots_size = (size_t)hdr.slot_count * sizeof(AlbumSlot);
+    if (pread(fd, slots, slots_size, album_slot_offset(0)) != (ssize_t)slots_size) {
+        free(slots);
+        close(fd);
+        return -1;
+    }
+
+    int album_count = 0;
+    for (Album *a = g_albums; a; a = a->next) album_count++;
+    Album **by_id = malloc((album_count ? album_count : 1) * sizeof(Album*));
+    if (!by_id) {
+        free(slots);
+        close(fd);
         return -1;
     }
-    fwrite(&a->album_id, sizeof(int), 1, fp);
-    int song_count = 0;
-    for (AlbumNode *n = a->head; n; n = n->next) song_count++;
-    fwrite(&song_count, sizeof(int), 1, fp);
-    for (AlbumNode *n = a->head; n; n = n->next) {
-        if (n->song) {
-            fwrite(&n->song->song_id, sizeof(int), 1, fp);
+    int n = 0;
+    for (Album *a = g_albums; a; a = a->next) {
+        a->store_slot = -1;
+        by_id[n++] = a;
+    }
+    qsort(by_id, n, sizeof(Album*), compare_album_ids);
+
+    int rc = 0;
+    for (uint32_t i = 0; i < hdr.slot_count; i++) {
+        if (!(slots[i].flags & ALBUM_SLOT_LIVE)) continue;
+        Album key = { .album_id = slots[i].album_id };
+        Album *key_ptr = &key;
+        Album **found = bsearch(&key_ptr, by_id, n, sizeof(Album*), compare_album_ids);
+        if (found) {
+            (*found)->store_slot = (int)i;
+            continue;
         }
+        slots[i].flags &= ~ALBUM_SLOT_LIVE;
+        hdr.heap_garbage += slots[i].name_len + (uint64_t)slots[i].track_capacity * sizeof(int32_t);
+        if (pwrite_all(fd, &slots[i], sizeof(AlbumSlot), album_slot_offset(i)) != 0) rc = -1;
+    }
+    free(by_id);
+    free(slots);
+
+    if (g_album_store_fd >= 0) close(g_album_store_fd);
+    g_album_store_fd = fd;
+    g_album_store = hdr;
+    if (rc == 0) rc = album_store_write_header();
+    if (rc != 0) perror("Failed to update albums.db");
+
+    for (Album *a = g_albums; a; a = a->next) {
+        if (a->store_slot < 0) album_mark_dirty(a);
     }
-    fclose(fp);
+    return rc;
+}
+
+/* Appends bytes to the heap and returns their offset in *off_out. */
+static int album_store_heap_append(const void *buf, size_t len, uint64_t *off_out) {
+    uint64_t off = g_album_store.heap_end;
+    if (pwrite_all(g_album_store_fd, buf, len, (off_t)off) != 0) return -1;
+    g_album_store.heap_end += len;
+    *off_out = off;
     return 0;
 }
 
-void load_all_albums() {
-    DIR *d = opendir("utils/albums/");
+/* Writes an album's current tracks into the store: in place when its track
+ * array still has room, otherwise into a new array. New albums take the next
+ * free slot; a full directory or a mostly-dead heap triggers a rewrite. */
+int save_album_to_bin(Album *a) {
+    if (!a || !a->name || g_album_store_disabled) return -1;
+    if (g_album_store_fd < 0) return album_store_rewrite();
+
+    if (a->store_slot < 0 && g_album_store.slot_count == g_album_store.slot_capacity) {
+        return album_store_rewrite();
+    }
+
+    int32_t *ids = album_track_ids(a);
+    if (!ids) return -1;
+    size_t ids_size = (size_t)a->track_count * sizeof(int32_t);
+
+    AlbumSlot e;
+    uint32_t slot;
+    int rc = 0;
+    if (a->store_slot < 0) {
+        slot = g_album_store.slot_count;
+        memset(&e, 0, sizeof(e));
+        e.album_id = a->album_id;
+        e.flags = ALBUM_SLOT_LIVE;
+        e.name_len = (uint32_t)strlen(a->name);
+        rc = album_store_heap_append(a->name, e.name_len, &e.name_off);
+    } else {
+        slot = (uint32_t)a->store_slot;
+        if (pread(g_album_store_fd, &e, sizeof(e), album_slot_offset(slot)) != sizeof(e)) rc = -1;
+    }
+
+    if (rc == 0 && a->store_slot >= 0 && (uint32_t)a->track_count <= e.track_capacity) {
+        rc = pwrite_all(g_album_store_fd, ids, ids_size, (off_t)e.tracks_off);
+    } else if (rc == 0) {
+        g_album_store.heap_garbage += (uint64_t)e.track_capacity * sizeof(int32_t);
+        e.track_capacity = album_track_capacity(a->track_count);
+        int32_t *grown = calloc(e.track_capacity, sizeof(int32_t));
+        if (!grown) {
+            rc = -1;
+        } else {
+            memcpy(grown, ids, ids_size);
+            rc = album_store_heap_append(grown, e.track_capacity * sizeof(int32_t), &e.tracks_off);
+            free(grown);
+        }
+    }
+    free(ids);
+
+    if (rc == 0) {
+        e.track_count = (uint32_t)a->track_count;
+        rc = pwrite_all(g_album_store_fd, &e, sizeof(e), album_slot_offset(slot));
+    }
+    if (rc == 0 && a->store_slot < 0) {
+        g_album_store.slot_count++;
+        a->store_slot = (int)slot;
+    }
+    if (rc == 0) rc = album_store_write_header();
+    if (rc != 0) {
+        perror("Failed to update albums.db");
+        return -1;
+    }
+
+    if (g_album_store.heap_garbage > 64 * 1024 &&
+        g_album_store.heap_garbage * 2 > g_album_store.heap_end) {
+        return album_store_rewrite();
+    }
+    return 0;
+}
+
+/* Marks an album's slot dead; its heap space is reclaimed by the next
+ * rewrite. */
+int delete_album_from_store(Album *a) {
+    if (!a || a->store_slot < 0 || g_album_store_fd < 0) return -1;
+
+    AlbumSlot e;
+    off_t off = album_slot_offset((uint32_t)a->store_slot);
+    if (pread(g_album_store_fd, &e, sizeof(e), off) != sizeof(e)) return -1;
+    e.flags &= ~ALBUM_SLOT_LIVE;
+    g_album_store.heap_garbage += e.name_len + (uint64_t)e.track_capacity * sizeof(int32_t);
+    if (pwrite_all(g_album_store_fd, &e, sizeof(e), off) != 0 || album_store_write_header() != 0) {
+        perror("Failed to update albums.db");
+        return -1;
+    }
+    a->store_slot = -1;
+    return 0;
+}
+
+/* Loads every live album from albums.db. Returns the number loaded, -1 if the
+ * store does not exist, or -2 if it is corrupt. */
+static int load_albums_from_store() {
+    int fd = open(ALBUMS_DB_PATH, O_RDWR | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(AlbumStoreHeader)) {
+        close(fd);
+        return -2;
+    }
+    size_t size = (size_t)st.st_size;
+    const char *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return -2;
+    }
+
+    AlbumStoreHeader hdr;
+    memcpy(&hdr, map, sizeof(hdr));
+    if (memcmp(hdr.magic, ALBUMS_DB_MAGIC, 4) != 0 || hdr.version != ALBUMS_DB_VERSION ||
+        hdr.slot_count > hdr.slot_capacity ||
+        (uint64_t)album_slot_offset(hdr.slot_capacity) > size || hdr.heap_end > size) {
+        munmap((void*)map, size);
+        close(fd);
+        return -2;
+    }
+
+    int count = 0;
+    const AlbumSlot *slots = (const AlbumSlot*)(map + sizeof(AlbumStoreHeader));
+    for (uint32_t i = 0; i < hdr.slot_count; i++) {
+        AlbumSlot e = slots[i];
+        if (!(e.flags & ALBUM_SLOT_LIVE)) continue;
+        if (e.name_off + e.name_len > size || e.track_count > e.track_capacity ||
+            e.tracks_off + (uint64_t)e.track_capacity * sizeof(int32_t) > size) {
+            continue;
+        }
+
+        char *name = strndup(map + e.name_off, e.name_len);
+        Album *album = name ? create_album_internal(name) : NULL;
+        free(name);
+        if (!album) continue;
+
+        album->album_id = e.album_id;
+        album->store_slot = (int)i;
+        if (e.album_id >= g_next_album_id) g_next_album_id = e.album_id + 1;
+
+        album_reserve(album, (int)e.track_count);
+        const int32_t *ids = (const int32_t*)(map + e.tracks_off);
+        for (uint32_t t = 0; t < e.track_count; t++) {
+            Song *song = find_song_by_id(ids[t]);
+            if (song) album_append_song(album, song);
+        }
+        count++;
+    }
+
+    munmap((void*)map, size);
+    g_album_store_fd = fd;
+    g_album_store = hdr;
+    return count;
+}
+
+/* Reads the original one-file-per-album layout under utils/albums/. */
+static int load_albums_legacy() {
+    DIR *d = opendir(ALBUMS_DIR);
     if (!d) {
         printf("No albums directory found.\n");
-        return;
+        return 0;
     }
     
     struct dirent *entry;
@@ -230,8 +670,7 @@ void load_all_albums() {
         if (!ext || strcmp(ext, ".bin") != 0) continue;
         
         char filepath[512];
-        snprintf(filepath, sizeof(filepath), "utils/albums/%s", name);
-        
+        snprintf(filepath, sizeof(filepath), ALBUMS_DIR "%s", name);
         FILE *fp = fopen(filepath, "rb");
         if (!fp) continue;
         
@@ -267,19 +706,13 @@ void load_all_albums() {
             fclose(fp);
             continue;
         }
+        if (song_count > 0) album_reserve(album, song_count);
         
         for (int i = 0; i < song_count; i++) {
             int song_id;
             if (fread(&song_id, sizeof(int), 1, fp) != 1) break;
             
-            Song *song = NULL;
-            for (Song *s = g_songs; s; s = s->next) {
-                if (s->song_id == song_id) {
-                    song = s;
-                    break;
-                }
-            }
-            
+            Song *song = find_song_by_id(song_id);
             if (song) album_append_song(album, song);
         }
         
@@ -288,6 +721,32 @@ void load_all_albums() {
     }
     
     closedir(d);
+    return count;
+}
+
+void load_all_albums() {
+    int count = load_albums_from_store();
+
+    /* A damaged store is set aside, never rebuilt from the per-album files:
+     * those stopped being updated at migration and would lose later edits. */
+    if (count == -2) {
+        if (rename(ALBUMS_DB_PATH, ALBUMS_DB_PATH ".corrupt") == 0) {
+            printf("Error! albums.db is corrupt or from another version; moved it to %s.\n",
+                   ALBUMS_DB_PATH ".corrupt");
+        } else {
+            perror("Failed to move aside albums.db");
+            printf("Error! albums.db is corrupt or from another version; album changes will not be saved.\n");
+            g_album_store_disabled = 1;
+        }
+        count = 0;
+    } else if (count == -1) {
+        count = load_albums_legacy();
+        /* The per-album files are left in place but no longer read. */
+        if (album_store_rewrite() == 0 && count > 0) {
+            printf("Migrated %d albums to %s.\n", count, ALBUMS_DB_PATH);
+        }
+    }
+
     printf("Loaded %d albums.\n", count);
 }
 
@@ -299,7 +758,10 @@ void listAlbums() {
     }
     int index = 1;
     for (Album *a = g_albums; a; a = a->next, index++) {
-        printf("%d. %s\n", index, a->name);
+        long secs = a->total_seconds;
+        printf("%d. %s (%d song%s, %02ld:%02ld:%02ld)\n", index, a->name,
+               a->track_count, a->track_count == 1 ? "" : "s",
+               secs / 3600, (secs % 3600) / 60, secs % 60);
     }
 }
 
@@ -323,25 +785,20 @@ void listSongsInAlbum(const char *albumname) {
         return;
     }
     
-    if (!a->head) {
+    if (a->track_count == 0) {
         printf("Album \"%s\" is empty\n", albumname);
         return;
     }
     
     printf("\nAlbum: %s\n\n", a->name);
     
-    int idx = 1;
-    for (AlbumNode *n = a->head; n; n = n->next, ++idx) {
-        Song *s = n->song;
-        if (s) {
-            printf("%d. %s - %s (%02d:%02d:%02d)\n",
-                   idx,
-                   s->title ? s->title : "(untitled)",
-                   s->artist ? s->artist : "(unknown)",
-                   s->length.hh, s->length.mm, s->length.ss);
-        } else {
-            printf("%d. (missing song)\n", idx);
-        }
+    for (int i = 0; i < a->track_count; i++) {
+        Song *s = a->tracks[i];
+        printf("%d. %s - %s (%02d:%02d:%02d)\n",
+               i + 1,
+               s->title ? s->title : "(untitled)",
+               s->artist ? s->artist : "(unknown)",
+               s->length.hh, s->length.mm, s->length.ss);
     }
 }
 
@@ -357,7 +814,7 @@ static Song* resolve_library_song_token(const char *token) {
     if (!token) return NULL;
     if (is_number(token)) {
         int idx = atoi(token);
-        return find_song_in_library_by_index(idx);
+        return find_song_by_number(idx);
     }
     return find_song_by_title_interactive(token);
 }
@@ -376,7 +833,7 @@ void createAlbum(const char *albumname, const char *songs[], int count) {
     printf("Created album \"%s\"\n", albumname);
 
     if (!songs || count <= 0) {
-        save_album_to_bin(a);
+        album_mark_dirty(a);
         return;
     }
 
@@ -390,7 +847,7 @@ void createAlbum(const char *albumname, const char *songs[], int count) {
             continue;
         }
 
-        if (album_find_node(a, s->title, NULL)) {
+        if (album_find_track(a, s->title) >= 0) {
             printf("Skipping \"%s\": already in album \"%s\"\n", s->title, albumname);
             continue;
         }
@@ -404,7 +861,7 @@ void createAlbum(const char *albumname, const char *songs[], int count) {
         printf("Added \"%s\" to album \"%s\"\n", s->title, albumname);
     }
     
-    save_album_to_bin(a);
+    album_mark_dirty(a);
 }
 
 void handleCreateAlbum(Command *cmd) {
@@ -423,13 +880,14 @@ void handleCreateAlbum(Command *cmd) {
     free(songs);
 }
 
-static AlbumNode* resolve_album_song_token(Album *a, const char *token, AlbumNode **prev_out) {
-    if (!a || !token) return NULL;
+// Slot of the track named by position or title, or -1
+static int resolve_album_song_token(Album *a, const char *token) {
+    if (!a || !token) return -1;
     if (is_number(token)) {
         int pos = atoi(token);
-        return album_node_at_index(a, pos, prev_out);
+        return album_track_at(a, pos);
     }
-    return album_find_node(a, token, prev_out);
+    return album_find_track(a, token);
 }
 
 void manageAddSong(const char *albumname, const char *songname) {
@@ -455,7 +913,7 @@ void manageAddSong(const char *albumname, const char *songname) {
         printf("Created album \"%s\"\n", albumname);
     }
 
-    if (album_find_node(a, s->title, NULL)) {
+    if (album_find_track(a, s->title) >= 0) {
         printf("Song \"%s\" already in album \"%s\"\n", s->title, albumname);
         return;
     }
@@ -465,7 +923,7 @@ void manageAddSong(const char *albumname, const char *songname) {
         return;
     }
     
-    save_album_to_bin(a);
+    album_mark_dirty(a);
     printf("Added \"%s\" to album \"%s\"\n", s->title, albumname);
 }
 
@@ -493,39 +951,24 @@ void manageSwapSongs(const char *albumname, const char *song1, const char *song2
         return;
     }
 
-    AlbumNode *prev1 = NULL, *prev2 = NULL;
-    AlbumNode *n1 = resolve_album_song_token(a, song1, &prev1);
-    AlbumNode *n2 = resolve_album_song_token(a, song2, &prev2);
+    int i1 = resolve_album_song_token(a, song1);
+    int i2 = resolve_album_song_token(a, song2);
 
-    if (!n1 || !n2) {
+    if (i1 < 0 || i2 < 0) {
         printf("One or both songs not found in album \"%s\"\n", albumname);
         return;
     }
 
-    if (n1 == n2) {
+    if (i1 == i2) {
         printf("Both references refer to the same entry; nothing to swap\n");
         return;
     }
 
-    AlbumNode *p1 = prev1, *p2 = prev2;
-    AlbumNode *a1 = n1->next, *a2 = n2->next;
-
-    if (p1) p1->next = n2; else a->head = n2;
-    if (p2) p2->next = n1; else a->head = n1;
+    Song *tmp = a->tracks[i1];
+    a->tracks[i1] = a->tracks[i2];
+    a->tracks[i2] = tmp;
 
-    if (n1->next == n2) {
-        n2->next = n1;
-        n1->next = a2;
-    } else if (n2->next == n1) {
-        n1->next = n2;
-        n2->next = a1;
-    } else {
-        AlbumNode *tmp = n1->next;
-        n1->next = n2->next;
-        n2->next = tmp;
-    }
-
-    save_album_to_bin(a);
+    album_mark_dirty(a);
     printf("Swapped entries in album \"%s\".\n", albumname);
 }
 
@@ -550,32 +993,25 @@ void manageMoveSong(const char *albumname, const char *songname, int position) {
         return;
     }
 
-    AlbumNode *prev = NULL;
-    AlbumNode *node = resolve_album_song_token(a, songname, &prev);
-    if (!node) {
+    int from = resolve_album_song_token(a, songname);
+    if (from < 0) {
         printf("Song \"%s\" not found in album \"%s\"\n", songname, albumname);
         return;
     }
 
-    if (!prev) a->head = node->next;
-    else prev->next = node->next;
-    node->next = NULL;
+    // Positions past the end move the song to the end
+    int to = position - 1;
+    if (to > a->track_count - 1) to = a->track_count - 1;
 
-    if (position == 1 || !a->head) {
-        node->next = a->head;
-        a->head = node;
-    } else {
-        AlbumNode *cur = a->head;
-        int idx = 1;
-        while (cur->next && idx < position - 1) {
-            cur = cur->next;
-            idx++;
-        }
-        node->next = cur->next;
-        cur->next = node;
+    Song *s = a->tracks[from];
+    if (to > from) {
+        memmove(&a->tracks[from], &a->tracks[from + 1], (to - from) * sizeof(Song*));
+    } else if (to < from) {
+        memmove(&a->tracks[to + 1], &a->tracks[to], (from - to) * sizeof(Song*));
     }
+    a->tracks[to] = s;
     
-    save_album_to_bin(a);
+    album_mark_dirty(a);
     printf("Moved entry to position %d in album \"%s\"\n", position, albumname);
 }
 
@@ -600,18 +1036,17 @@ void manageDeleteSong(const char *albumname, const char *songname) {
         return;
     }
 
-    AlbumNode *prev = NULL;
-    AlbumNode *node = resolve_album_song_token(a, songname, &prev);
-    if (!node) {
+    int i = resolve_album_song_token(a, songname);
+    if (i < 0) {
         printf("Song \"%s\" not found in album \"%s\"\n", songname, albumname);
         return;
     }
 
-    if (!prev) a->head = node->next;
-    else prev->next = node->next;
-    free(node);
+    a->total_seconds -= length_to_seconds(&a->tracks[i]->length);
+    a->track_count--;
+    memmove(&a->tracks[i], &a->tracks[i + 1], (a->track_count - i) * sizeof(Song*));
     
-    save_album_to_bin(a);
+    album_mark_dirty(a);
     printf("Deleted entry from album \"%s\"\n", albumname);
 }
 
@@ -635,28 +1070,24 @@ void deleteAlbum(const char *albumname) {
         return;
     }
     
-    char filepath[512];
-    snprintf(filepath, sizeof(filepath), "utils/albums/%s_%d.bin", a->name, a->album_id);
+    album_forget_dirty(a);
+    int removed = a->store_slot < 0 || delete_album_from_store(a) == 0;
     
     if (a->prev) a->prev->next = a->next;
     else g_albums = a->next;
+    g_albums_generation++;
     
     if (a->next) a->next->prev = a->prev;
     
-    AlbumNode *node = a->head;
-    while (node) {
-        AlbumNode *next = node->next;
-        free(node);
-        node = next;
-    }
+    free(a->tracks);
     
     free(a->name);
     free(a);
     
-    if (remove(filepath) == 0) {
+    if (removed) {
         printf("Deleted album \"%s\"\n", albumname);
     } else {
-        printf("Failed to delete album file, but removed from memory.\n");
+        printf("Failed to delete album from the album store, but removed from memory.\n");
     }
 }
 
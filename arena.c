@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "include/arena.h"
+#include "include/structures.h"
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+struct PoolSlab {
+    union {
+        struct PoolSlab *next;
+        max_align_t align;
+    } hdr;
+};
+
+struct ArenaBlock {
+    union {
+        struct ArenaBlock *next;
+        max_align_t align;
+    } hdr;
+};
+
+Pool g_song_pool = POOL_INIT("songs", Song, next, 1024);
+Pool g_playlist_node_pool = POOL_INIT("playlist nodes", PlaylistNode, next, 256);
+StringArena g_string_arena = {"strings", NULL, NULL, 0, 0, 0, 0};
+StringInterner g_interner = {"interned", &g_string_arena, NULL, 0, 0, 0, 0};
+
+struct InternSlot {
+    char *str;
+    uint32_t len;
+    uint32_t hash;
+};
+
+static void** pool_link(Pool *p, void *obj) {
+    return (void**)((char*)obj + p->link_offset);
+}
+
+void* pool_alloc(Pool *p) {
+    void *obj;
+    if (p->free_list) {
+        obj = p->free_list;
+        p->free_list = *pool_link(p, obj);
+    } else {
+        if (p->bump_left == 0) {
+            PoolSlab *slab = malloc(sizeof(PoolSlab) + p->obj_size * p->objs_per_slab);
+            if (!slab) return NULL;
+            slab->hdr.next = p->slabs;
+            p->slabs = slab;
+            p->bump = (char*)(slab + 1);
+            p->bump_left = p->objs_per_slab;
+            p->slab_count++;
+        }
+        obj = p->bump;
+        p->bump += p->obj_size;
+        p->bump_left--;
+    }
+    p->live++;
+    p->allocs++;
+    return obj;
+}
+
+void pool_free(Pool *p, void *obj) {
+    if (!obj) return;
+    *pool_link(p, obj) = p->free_list;
+    p->free_list = obj;
+    p->live--;
+}
+
+void pool_release_all(Pool *p) {
+    PoolSlab *slab = p->slabs;
+    while (slab) {
+        PoolSlab *next = slab->hdr.next;
+        free(slab);
+        slab = next;
+    }
+    p->slabs = NULL;
+    p->bump = NULL;
+    p->bump_left = 0;
+    p->free_list = NULL;
+    p->live = 0;
+    p->slab_count = 0;
+}
+
+char* arena_strndup(StringArena *a, const char *s, size_t n) {
+    if (!s) return NULL;
+    if (n + 1 > a->left) {
+        size_t block_size = n + 1 > ARENA_BLOCK_SIZE ? n + 1 : ARENA_BLOCK_SIZE;
+        ArenaBlock *block = malloc(sizeof(ArenaBlock) + block_size);
+        if (!block) return NULL;
+        block->hdr.next = a->blocks;
+        a->blocks = block;
+        a->cur = (char*)(block + 1);
+        a->left = block_size;
+        a->reserved += block_size;
+    }
+    char *out = a->cur;
+    memcpy(out, s, n);
+    out[n] = '\0';
+    a->cur += n + 1;
+    a->left -= n + 1;
+    a->strings++;
+    a->used += n + 1;
+    return out;
+}
+
+char* arena_strdup(StringArena *a, const char *s) {
+    if (!s) return NULL;
+    return arena_strndup(a, s, strlen(s));
+}
+
+/* Frees every block of a private arena, leaving it empty. */
+void arena_release(StringArena *a) {
+    ArenaBlock *block = a->blocks;
+    while (block) {
+        ArenaBlock *next = block->hdr.next;
+        free(block);
+        block = next;
+    }
+    a->blocks = NULL;
+    a->cur = NULL;
+    a->left = 0;
+    a->strings = 0;
+    a->used = 0;
+    a->reserved = 0;
+}
+
+static uint32_t intern_hash(const char *s, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int intern_grow(StringInterner *in) {
+    size_t new_cap = in->capacity ? in->capacity * 2 : 1024;
+    InternSlot *slots = calloc(new_cap, sizeof(InternSlot));
+    if (!slots) return -1;
+    for (size_t i = 0; i < in->capacity; i++) {
+        InternSlot *old = &in->slots[i];
+        if (!old->str) continue;
+        size_t j = old->hash & (new_cap - 1);
+        while (slots[j].str) j = (j + 1) & (new_cap - 1);
+        slots[j] = *old;
+    }
+    free(in->slots);
+    in->slots = slots;
+    in->capacity = new_cap;
+    return 0;
+}
+
+/* Finds the slot holding s, or the empty slot where it belongs. */
+static InternSlot* intern_find(StringInterner *in, const char *s, size_t n, uint32_t hash) {
+    size_t mask = in->capacity - 1;
+    size_t i = hash & mask;
+    for (; in->slots[i].str; i = (i + 1) & mask) {
+        InternSlot *slot = &in->slots[i];
+        if (slot->hash == hash && slot->len == n && memcmp(slot->str, s, n) == 0) break;
+    }
+    return &in->slots[i];
+}
+
+/* Returns the canonical copy of s[0..n), storing s itself (copy false) or an
+ * arena copy of it (copy true) if it is new. */
+static char* intern_lookup(StringInterner *in, char *s, size_t n, int copy) {
+    if (!s || n > UINT32_MAX) return NULL;
+    if ((in->count + 1) * 4 > in->capacity * 3 && intern_grow(in) != 0) return NULL;
+
+    uint32_t hash = intern_hash(s, n);
+    InternSlot *slot = intern_find(in, s, n, hash);
+    in->lookups++;
+    if (slot->str) {
+        in->bytes_saved += n + 1;
+        return slot->str;
+    }
+
+    char *str = copy ? arena_strndup(in->arena, s, n) : s;
+    if (!str) return NULL;
+    slot->str = str;
+    slot->len = (uint32_t)n;
+    slot->hash = hash;
+    in->count++;
+    return str;
+}
+
+char* intern_strndup(StringInterner *in, const char *s, size_t n) {
+    return intern_lookup(in, (char*)s, n, 1);
+}
+
+char* intern_strdup(StringInterner *in, const char *s) {
+    if (!s) return NULL;
+    return intern_lookup(in, (char*)s, strlen(s), 1);
+}
+
+char* intern_adopt(StringInterner *in, char *s, size_t n) {
+    return intern_lookup(in, s, n, 0);
+}
+
+static void pool_print_stats(const Pool *p) {
+    size_t reserved = p->slab_count * (sizeof(PoolSlab) + p->obj_size * p->objs_per_slab);
+    printf("%-16s %10zu %12zu %8zu %12zu %12zu\n",
+           p->name, p->live, p->allocs, p->slab_count, p->live * p->obj_size, reserved);
+}
+
+void arena_print_stats() {
+    printf("%-16s %10s %12s %8s %12s %12s\n",
+           "pool", "live", "allocations", "slabs", "bytes used", "bytes held");
+    pool_print_stats(&g_song_pool);
+    pool_print_stats(&g_playlist_node_pool);
+    printf("%-16s %10zu %12zu %8s %12zu %12zu\n",
+           g_string_arena.name, g_string_arena.strings, g_string_arena.strings, "-",
+           g_string_arena.used, g_string_arena.reserved);
+    printf("\n%s: %zu distinct strings from %zu lookups, %zu bytes shared, %zu bytes of table\n",
+           g_interner.name, g_interner.count, g_interner.lookups,
+           g_interner.bytes_saved, g_interner.capacity * sizeof(InternSlot));
+}
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "songs.h"
+#include "albums.h"
+#include "utils.h"
+#include "persist.h"
+#include "textmatch.h"
+
+// Workload benchmark: builds a synthetic library in the current songs.bin and
+// utils/albums.db formats, then in a fresh process times the loaders, song and
+// album lookups by number and title, dispatchCommand, album edits and playlist
+// operations. Each result is one line of key=value pairs on stdout:
+//
+//   ops op=<name> n=<operations> total_ms=<ms> ns_per_op=<ns>
+//
+// Usage: bench_ops [songs [albums [playlist]]]
+
+#define TRACKS_PER_ALBUM 12
+#define LOOKUPS 100000
+#define DISPATCHES 20000
+#define ALBUM_EDITS 5000
+#define SHUFFLES 20
+
+static FILE *g_out;
+static unsigned long g_rng = 88172645463325252UL;
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// 1..n, from a fixed-seed xorshift so every run does the same work
+static int pick(int n) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return 1 + (int)(g_rng % (unsigned long)n);
+}
+
+static void report(const char *op, long n, double ms) {
+    fprintf(g_out, "ops op=%s n=%ld total_ms=%.2f ns_per_op=%.1f\n",
+            op, n, ms, n > 0 ? ms * 1e6 / n : 0.0);
+    fflush(g_out);
+}
+
+static int write_library(int song_count, int album_count) {
+    mkdir("utils", 0755);
+
+    Song **songs = malloc(song_count * sizeof(Song*));
+    if (!songs) return -1;
+    for (int i = 0; i < song_count; i++) {
+        char title[64], artist[64], length[16];
+        snprintf(title, sizeof(title), "Track %d", i + 1);
+        snprintf(artist, sizeof(artist), "Artist %d", (i + 1) % 997);
+        snprintf(length, sizeof(length), "00:%02d:%02d", (i + 1) % 60, ((i + 1) * 7) % 60);
+        songs[i] = song_alloc();
+        if (!songs[i] || song_init(songs[i], title, artist, length, 1950 + i % 75) != 0) return -1;
+    }
+    int added = song_count;
+    if (add_songs_to_library(songs, &added) != 0 || added != song_count) return -1;
+    free(songs);
+
+    for (int i = 0; i < album_count; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "Album %d", i + 1);
+        Album *a = create_album_internal(name);
+        if (!a) return -1;
+        for (int t = 0; t < TRACKS_PER_ALBUM; t++) {
+            album_append_song(a, find_song_by_id(pick(song_count)));
+        }
+        album_mark_dirty(a);
+    }
+    persist_flush_all();
+    return 0;
+}
+
+static void time_dispatch(const char *op, const char *fmt, int range) {
+    char line[MAX_LINE];
+    double t0 = now_ms();
+    for (int i = 0; i < DISPATCHES; i++) {
+        snprintf(line, sizeof(line), fmt, pick(range));
+        Command cmd = parseCommand(line);
+        dispatchCommand(&cmd);
+        freeCommand(&cmd);
+    }
+    report(op, DISPATCHES, now_ms() - t0);
+}
+
+static void time_album_edit(const char *op, const char *fmt, int album_count, int song_count) {
+    char line[MAX_LINE];
+    double t0 = now_ms();
+    for (int i = 0; i < ALBUM_EDITS; i++) {
+        snprintf(line, sizeof(line), fmt, pick(album_count), pick(song_count));
+        Command cmd = parseCommand(line);
+        dispatchCommand(&cmd);
+        freeCommand(&cmd);
+    }
+    report(op, ALBUM_EDITS, now_ms() - t0);
+}
+
+static void run_workload(int song_count, int album_count, int playlist_size) {
+    g_out = fdopen(dup(STDOUT_FILENO), "w");
+    int devnull = open("/dev/null", O_WRONLY);
+    fflush(stdout);
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+    g_batch_mode = 1;
+    init_playback_state();
+
+    double t0 = now_ms();
+    load_all_songs_from_bin();
+    report("load_songs", song_count, now_ms() - t0);
+
+    t0 = now_ms();
+    load_all_albums();
+    report("load_albums", album_count, now_ms() - t0);
+
+    volatile void *sink = NULL;
+    t0 = now_ms();
+    for (int i = 0; i < LOOKUPS; i++) sink = find_song_by_number(pick(song_count));
+    report("song_by_number", LOOKUPS, now_ms() - t0);
+
+    t0 = now_ms();
+    for (int i = 0; i < LOOKUPS; i++) sink = find_album_by_number(pick(album_count));
+    report("album_by_number", LOOKUPS, now_ms() - t0);
+
+    char title[64];
+    t0 = now_ms();
+    for (int i = 0; i < LOOKUPS; i++) {
+        snprintf(title, sizeof(title), "Track %d", pick(song_count));
+        sink = find_song_by_title_interactive(title);
+    }
+    report("song_by_title", LOOKUPS, now_ms() - t0);
+    (void)sink;
+
+    time_dispatch("dispatch_unknown", "FROBNICATE %d", 1);
+    time_dispatch("dispatch_list_in_album", "LIST IN ALBUM %d", album_count);
+    time_dispatch("dispatch_search", "SEARCH \"Track %d\"", song_count);
+
+    time_album_edit("album_add", "MANAGE ADD %d %d", album_count, song_count);
+    time_album_edit("album_swap", "MANAGE SWAP %d 1 %d", album_count, TRACKS_PER_ALBUM);
+    time_album_edit("album_move", "MANAGE MOVE %d 1 %d", album_count, TRACKS_PER_ALBUM);
+    time_album_edit("album_delete_song", "MANAGE DELETE %d %d", album_count, TRACKS_PER_ALBUM - 1);
+
+    t0 = now_ms();
+    int written = persist_flush();
+    report("album_flush", written, now_ms() - t0);
+
+    char (*titles)[32] = malloc(playlist_size * sizeof(*titles));
+    const char **names = malloc(playlist_size * sizeof(char*));
+    if (titles && names) {
+        for (int i = 0; i < playlist_size; i++) {
+            snprintf(titles[i], sizeof(titles[i]), "Track %d", pick(song_count));
+            names[i] = titles[i];
+        }
+
+        t0 = now_ms();
+        nextSongs(names, playlist_size);
+        report("playlist_add", playlist_size, now_ms() - t0);
+
+        t0 = now_ms();
+        for (int i = 0; i < SHUFFLES; i++) shuffle();
+        report("playlist_shuffle", SHUFFLES, now_ms() - t0);
+
+        t0 = now_ms();
+        for (int i = 0; i < playlist_size; i++) removeSong(names[i]);
+        report("playlist_remove", playlist_size, now_ms() - t0);
+    }
+    free(titles);
+    free(names);
+
+    cleanup_playback_state();
+    fclose(g_out);
+    exit(0);
+}
+
+int main(int argc, char *argv[]) {
+    int song_count = argc > 1 ? atoi(argv[1]) : 100000;
+    int album_count = argc > 2 ? atoi(argv[2]) : 5000;
+    int playlist_size = argc > 3 ? atoi(argv[3]) : 1000;
+    if (song_count < 1 || album_count < 1 || playlist_size < 1) {
+        fprintf(stderr, "Usage: %s [songs [albums [playlist]]]\n", argv[0]);
+        return 1;
+    }
+
+    char dir[] = "/tmp/c_unplugged_bench_XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    printf("ops_config songs=%d albums=%d playlist=%d tracks_per_album=%d textmatch=%s\n",
+           song_count, album_count, playlist_size, TRACKS_PER_ALBUM, textmatch_impl_name());
+    fflush(stdout);
+
+    // Generate in one process and measure in another, so the loaders start
+    // from files rather than warm in-memory state.
+    for (int run = 0; run < 2; run++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork failed");
+            return 1;
+        }
+        if (pid == 0) {
+            if (chdir(dir) != 0) exit(1);
+            if (run == 0) {
+                int devnull = open("/dev/null", O_WRONLY);
+                dup2(devnull, STDOUT_FILENO);
+                exit(write_library(song_count, album_count) == 0 ? 0 : 1);
+            }
+            run_workload(song_count, album_count, playlist_size);
+        }
+        int status;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "bench: %s failed\n", run == 0 ? "library generation" : "workload");
+            break;
+        }
+    }
+
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    if (system(cmd) != 0) fprintf(stderr, "bench: failed to remove %s\n", dir);
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "songs.h"
+#include "albums.h"
+
+// Startup benchmark: writes a synthetic library in the original songs.bin and
+// utils/albums/*.bin formats, then times load_all_songs_from_bin and
+// load_all_albums in a fresh child process for each catalogue size. The
+// first start reads the per-album files and migrates them to utils/albums.db;
+// a second start then loads from the album store.
+
+#define TRACKS_PER_ALBUM 12
+#define SONGS_PER_ALBUM 4
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static int write_library(int song_count, int album_count) {
+    mkdir("utils", 0755);
+    mkdir("utils/albums", 0755);
+
+    FILE *fp = fopen("utils/songs.bin", "wb");
+    if (!fp) return -1;
+    for (int id = 1; id <= song_count; id++) {
+        char title[64], artist[64];
+        int title_len = snprintf(title, sizeof(title), "Track %d", id);
+        int artist_len = snprintf(artist, sizeof(artist), "Artist %d", id % 997);
+        SongLength len = {0, id % 60, (id * 7) % 60};
+        int year = 1950 + id % 75;
+        fwrite(&title_len, sizeof(int), 1, fp);
+        fwrite(title, 1, title_len, fp);
+        fwrite(&artist_len, sizeof(int), 1, fp);
+        fwrite(artist, 1, artist_len, fp);
+        fwrite(&len, sizeof(SongLength), 1, fp);
+        fwrite(&year, sizeof(int), 1, fp);
+        fwrite(&id, sizeof(int), 1, fp);
+    }
+    fclose(fp);
+
+    for (int album_id = 1; album_id <= album_count; album_id++) {
+        char path[128];
+        snprintf(path, sizeof(path), "utils/albums/Album %d_%d.bin", album_id, album_id);
+        fp = fopen(path, "wb");
+        if (!fp) return -1;
+        int tracks = TRACKS_PER_ALBUM;
+        fwrite(&album_id, sizeof(int), 1, fp);
+        fwrite(&tracks, sizeof(int), 1, fp);
+        for (int t = 0; t < tracks; t++) {
+            int song_id = 1 + (int)(((long)album_id * 7919 + t * 104729L) % song_count);
+            fwrite(&song_id, sizeof(int), 1, fp);
+        }
+        fclose(fp);
+    }
+    return 0;
+}
+
+static void time_startup(int album_count, const char *layout) {
+    int song_count = album_count * SONGS_PER_ALBUM;
+
+    int saved_stdout = dup(STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    fflush(stdout);
+    dup2(devnull, STDOUT_FILENO);
+
+    double t0 = now_ms();
+    load_all_songs_from_bin();
+    double t1 = now_ms();
+    load_all_albums();
+    double t2 = now_ms();
+
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(devnull);
+
+    printf("startup layout=%s albums=%d songs=%d tracks_per_album=%d load_songs_ms=%.2f load_albums_ms=%.2f\n",
+           layout, album_count, song_count, TRACKS_PER_ALBUM, t1 - t0, t2 - t1);
+    exit(0);
+}
+
+int main(int argc, char *argv[]) {
+    int sizes[] = {1000, 2500, 5000, 10000, 20000};
+    int size_count = sizeof(sizes) / sizeof(sizes[0]);
+
+    for (int i = 0; i < size_count; i++) {
+        if (argc > 1 && atoi(argv[1]) > 0 && sizes[i] > atoi(argv[1])) break;
+
+        char dir[] = "/tmp/c_unplugged_bench_XXXXXX";
+        if (!mkdtemp(dir)) {
+            perror("mkdtemp");
+            return 1;
+        }
+
+        const char *layouts[] = {"legacy", "store"};
+        for (int run = 0; run < 2; run++) {
+            pid_t pid = fork();
+            if (pid < 0) {
+                perror("fork failed");
+                return 1;
+            }
+            if (pid == 0) {
+                if (chdir(dir) != 0) exit(1);
+                if (run == 0 && write_library(sizes[i] * SONGS_PER_ALBUM, sizes[i]) != 0) {
+                    fprintf(stderr, "bench: failed to write synthetic library\n");
+                    exit(1);
+                }
+                time_startup(sizes[i], layouts[run]);
+            }
+            waitpid(pid, NULL, 0);
+        }
+
+        char cmd[128];
+        snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+        if (system(cmd) != 0) fprintf(stderr, "bench: failed to remove %s\n", dir);
+    }
+    return 0;
+}
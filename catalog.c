@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "include/catalog.h"
+#include "include/songs.h"
+#include "include/textmatch.h"
+#include "include/arena.h"
+
+Catalog g_catalog;
+
+static int catalog_grow() {
+    int new_cap = g_catalog.capacity ? g_catalog.capacity * 2 : 1024;
+    int *ids = realloc(g_catalog.ids, new_cap * sizeof(int));
+    if (ids) g_catalog.ids = ids;
+    int *years = realloc(g_catalog.years, new_cap * sizeof(int));
+    if (years) g_catalog.years = years;
+    int *seconds = realloc(g_catalog.seconds, new_cap * sizeof(int));
+    if (seconds) g_catalog.seconds = seconds;
+    const char **titles = realloc(g_catalog.titles, new_cap * sizeof(char*));
+    if (titles) g_catalog.titles = titles;
+    const char **artists = realloc(g_catalog.artists, new_cap * sizeof(char*));
+    if (artists) g_catalog.artists = artists;
+    const char **folded_titles = realloc(g_catalog.folded_titles, new_cap * sizeof(char*));
+    if (folded_titles) g_catalog.folded_titles = folded_titles;
+    const char **folded_artists = realloc(g_catalog.folded_artists, new_cap * sizeof(char*));
+    if (folded_artists) g_catalog.folded_artists = folded_artists;
+    Song **songs = realloc(g_catalog.songs, new_cap * sizeof(Song*));
+    if (songs) g_catalog.songs = songs;
+
+    if (!ids || !years || !seconds || !titles || !artists ||
+        !folded_titles || !folded_artists || !songs) {
+        return -1;
+    }
+    g_catalog.capacity = new_cap;
+    return 0;
+}
+
+/* Interned lower-case copy of an interned string. Consecutive songs usually
+ * share an artist, so the last result is reused by pointer. A string that is
+ * already lower case folds to itself. */
+static const char* catalog_fold(const char *s) {
+    static const char *last_in = NULL;
+    static const char *last_out = NULL;
+    if (s == last_in) return last_out;
+
+    char *folded = ascii_fold_dup(s);
+    if (!folded) return NULL;
+    const char *out = intern_strdup(&g_interner, folded);
+    free(folded);
+    if (out) {
+        last_in = s;
+        last_out = out;
+    }
+    return out;
+}
+
+int catalog_append(Song *s) {
+    if (!s || !s->title || !s->artist) return -1;
+    if (g_catalog.count == g_catalog.capacity && catalog_grow() != 0) return -1;
+
+    int row = g_catalog.count;
+    const char *folded_title = catalog_fold(s->title);
+    const char *folded_artist = catalog_fold(s->artist);
+    if (!folded_title || !folded_artist) return -1;
+
+    g_catalog.titles[row] = s->title;
+    g_catalog.artists[row] = s->artist;
+    g_catalog.folded_titles[row] = folded_title;
+    g_catalog.folded_artists[row] = folded_artist;
+    g_catalog.ids[row] = s->song_id;
+    g_catalog.years[row] = s->year;
+    g_catalog.seconds[row] = (int)length_to_seconds(&s->length);
+    g_catalog.songs[row] = s;
+    g_catalog.count++;
+    return row;
+}
+
+long catalog_total_seconds() {
+    long total = 0;
+    const int *seconds = g_catalog.seconds;
+    for (int i = 0; i < g_catalog.count; i++) total += seconds[i];
+    return total;
+}
+
+int catalog_rows_for_year(int year, int *rows_out) {
+    int matched = 0;
+    const int *years = g_catalog.years;
+    for (int i = 0; i < g_catalog.count; i++) {
+        if (years[i] == year) {
+            if (rows_out) rows_out[matched] = i;
+            matched++;
+        }
+    }
+    return matched;
+}
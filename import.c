@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "include/import.h"
+#include "include/songs.h"
+#include "include/arena.h"
+
+#define IMPORT_MAX_THREADS 16
+#define IMPORT_MIN_CHUNK (256 * 1024)
+#define IMPORT_MAX_REPORTED 10
+
+typedef struct ImportRow {
+    char *title;
+    char *artist;
+    SongLength length;
+    int year;
+} ImportRow;
+
+typedef struct ImportError {
+    long line;
+    const char *reason;
+} ImportError;
+
+/* One worker's share of the file: whole lines in [begin, end). Strings go
+ * into the chunk's own arena, so workers never share an allocator; they are
+ * interned into g_string_arena when the songs are added and the chunk arena
+ * is then freed. */
+typedef struct ImportChunk {
+    const char *begin;
+    const char *end;
+    char delim;
+    StringArena arena;
+    ImportRow *rows;
+    size_t count;
+    size_t capacity;
+    long lines;
+    long bad;
+    ImportError errors[IMPORT_MAX_REPORTED];
+} ImportChunk;
+
+/* Reads one field starting at *p and stops after the delimiter; *p becomes
+ * NULL once the last field on the line has been read. Returns the field in
+ * scratch, NUL-terminated, or NULL if it is missing, malformed or does not
+ * fit. */
+static char* read_field(const char **p, const char *end, char delim, char *scratch, size_t cap) {
+    const char *s = *p;
+    size_t n = 0;
+    if (!s) return NULL;
+
+    while (s < end && (*s == ' ' || (*s == '\t' && delim != '\t'))) s++;
+
+    if (s < end && *s == '"') {
+        s++;
+        for (;;) {
+            if (s >= end) return NULL;
+            if (*s == '"') {
+                if (s + 1 < end && s[1] == '"') {
+                    s++;
+                } else {
+                    s++;
+                    break;
+                }
+            }
+            if (n + 1 >= cap) return NULL;
+            scratch[n++] = *s++;
+        }
+        while (s < end && *s != delim) {
+            if (*s != ' ' && *s != '\t') return NULL;
+            s++;
+        }
+    } else {
+        while (s < end && *s != delim) {
+            if (n + 1 >= cap) return NULL;
+            scratch[n++] = *s++;
+        }
+        while (n > 0 && (scratch[n - 1] == ' ' || scratch[n - 1] == '\t')) n--;
+    }
+
+    *p = s < end ? s + 1 : NULL;
+    scratch[n] = '\0';
+    return scratch;
+}
+
+static int parse_year(const char *s, int *out) {
+    char *end;
+    long year = strtol(s, &end, 10);
+    if (*s == '\0' || *end != '\0' || year < 0 || year > 9999) return -1;
+    *out = (int)year;
+    return 0;
+}
+
+static void chunk_reject(ImportChunk *c, const char *reason) {
+    if (c->bad < IMPORT_MAX_REPORTED) {
+        c->errors[c->bad].line = c->lines;
+        c->errors[c->bad].reason = reason;
+    }
+    c->bad++;
+}
+
+static const char* parse_row(ImportChunk *c, const char *line, const char *end, ImportRow *row) {
+    char title[256], artist[256], length[32], year[16];
+    const char *p = line;
+
+    if (!read_field(&p, end, c->delim, title, sizeof(title)) ||
+        !read_field(&p, end, c->delim, artist, sizeof(artist)) ||
+        !read_field(&p, end, c->delim, length, sizeof(length)) ||
+        !read_field(&p, end, c->delim, year, sizeof(year))) {
+        return "malformed or missing field";
+    }
+    if (p) return "too many fields";
+    if (title[0] == '\0' || artist[0] == '\0') return "empty title or artist";
+    if (parse_length(length, &row->length) != 0) return "invalid length";
+    if (parse_year(year, &row->year) != 0) return "invalid year";
+
+    row->title = arena_strdup(&c->arena, title);
+    row->artist = arena_strdup(&c->arena, artist);
+    if (!row->title || !row->artist) return "out of memory";
+    return NULL;
+}
+
+static void* import_worker(void *arg) {
+    ImportChunk *c = arg;
+    const char *p = c->begin;
+
+    while (p < c->end) {
+        const char *nl = memchr(p, '\n', c->end - p);
+        const char *line_end = nl ? nl : c->end;
+        const char *next = nl ? nl + 1 : c->end;
+        if (line_end > p && line_end[-1] == '\r') line_end--;
+        c->lines++;
+
+        if (line_end == p) {
+            p = next;
+            continue;
+        }
+
+        if (c->count == c->capacity) {
+            size_t cap = c->capacity ? c->capacity * 2 : 4096;
+            ImportRow *rows = realloc(c->rows, cap * sizeof(ImportRow));
+            if (!rows) {
+                chunk_reject(c, "out of memory");
+                p = next;
+                continue;
+            }
+            c->rows = rows;
+            c->capacity = cap;
+        }
+
+        const char *reason = parse_row(c, p, line_end, &c->rows[c->count]);
+        if (reason) chunk_reject(c, reason);
+        else c->count++;
+        p = next;
+    }
+    return NULL;
+}
+
+/* Splits [begin, end) into up to `wanted` chunks that each end on a line
+ * boundary. Returns the number of chunks. */
+static int split_chunks(const char *begin, const char *end, char delim, ImportChunk *chunks, int wanted) {
+    size_t size = end - begin;
+    const char *start = begin;
+    int n = 0;
+    for (int i = 0; i < wanted && start < end; i++) {
+        const char *stop = end;
+        if (i + 1 < wanted) {
+            stop = begin + size * (i + 1) / wanted;
+            if (stop < start) stop = start;
+            const char *nl = memchr(stop, '\n', end - stop);
+            stop = nl ? nl + 1 : end;
+        }
+        memset(&chunks[n], 0, sizeof(ImportChunk));
+        chunks[n].begin = start;
+        chunks[n].end = stop;
+        chunks[n].delim = delim;
+        chunks[n].arena.name = "import";
+        n++;
+        start = stop;
+    }
+    return n;
+}
+
+static int import_thread_count(size_t size) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    long by_size = (long)(size / IMPORT_MIN_CHUNK) + 1;
+    long n = cpus < by_size ? cpus : by_size;
+    if (n > IMPORT_MAX_THREADS) n = IMPORT_MAX_THREADS;
+    return n < 1 ? 1 : (int)n;
+}
+
+static double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1000.0 + (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+int import_songs_from_file(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        printf("%s is empty.\n", path);
+        return 0;
+    }
+
+    size_t size = (size_t)st.st_size;
+    char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    struct timespec t0, t1, t2;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    const char *begin = data, *end = data + size;
+    const char *first_nl = memchr(begin, '\n', size);
+    const char *first_end = first_nl ? first_nl : end;
+    char delim = memchr(begin, '\t', first_end - begin) ? '\t' : ',';
+
+    /* Skip a header row so it is neither imported nor reported. */
+    long header_lines = 0;
+    char field[256];
+    const char *p = begin;
+    if (read_field(&p, first_end, delim, field, sizeof(field)) && strcasecmp(field, "title") == 0) {
+        begin = first_nl ? first_nl + 1 : end;
+        header_lines = 1;
+    }
+
+    ImportChunk chunks[IMPORT_MAX_THREADS];
+    pthread_t threads[IMPORT_MAX_THREADS];
+    int nchunks = split_chunks(begin, end, delim, chunks, import_thread_count(end - begin));
+
+    int started = 0;
+    for (int i = 1; i < nchunks; i++) {
+        if (pthread_create(&threads[i], NULL, import_worker, &chunks[i]) != 0) break;
+        started = i;
+    }
+    if (nchunks > 0) import_worker(&chunks[0]);
+    /* Any chunk whose thread could not be started is parsed here instead. */
+    for (int i = started + 1; i < nchunks; i++) import_worker(&chunks[i]);
+    for (int i = 1; i <= started; i++) pthread_join(threads[i], NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    size_t total = 0;
+    long bad = 0;
+    for (int i = 0; i < nchunks; i++) {
+        total += chunks[i].count;
+        bad += chunks[i].bad;
+    }
+
+    Song **songs = total ? malloc(total * sizeof(Song*)) : NULL;
+    int added = 0;
+    if (total && !songs) {
+        printf("Out of memory importing %s.\n", path);
+    } else {
+        int out_of_memory = 0;
+        for (int i = 0; i < nchunks && !out_of_memory; i++) {
+            for (size_t r = 0; r < chunks[i].count; r++) {
+                ImportRow *row = &chunks[i].rows[r];
+                Song *s = song_alloc();
+                if (!s) {
+                    out_of_memory = 1;
+                    break;
+                }
+                s->title = intern_strdup(&g_interner, row->title);
+                s->artist = intern_strdup(&g_interner, row->artist);
+                if (!s->title || !s->artist) {
+                    song_release(s);
+                    out_of_memory = 1;
+                    break;
+                }
+                s->length = row->length;
+                s->year = row->year;
+                s->song_id = g_next_song_id++;
+                songs[added++] = s;
+            }
+        }
+        int parsed = added;
+        if (added > 0 && add_songs_to_library(songs, &added) != 0) {
+            printf("Warning: songs.bin could not be rewritten; imported songs were journalled instead.\n");
+        }
+        if (out_of_memory || added < parsed) printf("Out of memory importing %s.\n", path);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+
+    printf("\nImported %d songs from %s", added, path);
+    if (bad > 0) printf(" (%ld invalid row%s skipped)", bad, bad == 1 ? "" : "s");
+    printf(".\nParsed in %.1f ms on %d thread%s, added and saved in %.1f ms.\n",
+           elapsed_ms(&t0, &t1), nchunks, nchunks == 1 ? "" : "s", elapsed_ms(&t1, &t2));
+
+    /* Chunk line counts turn each worker's local line numbers into file
+     * line numbers. */
+    long line_base = header_lines;
+    int reported = 0;
+    for (int i = 0; i < nchunks; i++) {
+        for (long e = 0; e < chunks[i].bad && e < IMPORT_MAX_REPORTED && reported < IMPORT_MAX_REPORTED; e++) {
+            printf("  line %ld: %s\n", line_base + chunks[i].errors[e].line, chunks[i].errors[e].reason);
+            reported++;
+        }
+        line_base += chunks[i].lines;
+        arena_release(&chunks[i].arena);
+        free(chunks[i].rows);
+    }
+    if (bad > reported) printf("  ... and %ld more\n", bad - reported);
+    printf("\n");
+
+    free(songs);
+    munmap(data, size);
+    return added;
+}
+
+void importSongs(const char *path) {
+    import_songs_from_file(path);
+}
+
+void handleImport(Command *cmd) {
+    if (cmd->count != 2) {
+        printf("Error! Invalid command format.\n");
+        printf("Usage: IMPORT <file>\n");
+        return;
+    }
+    importSongs(cmd->tokens[1]);
+}
@@ -13,11 +13,17 @@ Album** find_all_albums_by_name(const char *name, int *count);
 Album* find_album_by_number(int number);
 int is_number_album(const char *str);
 Album* create_album_internal(const char *name);
-AlbumNode* album_find_node(Album *a, const char *title, AlbumNode **prev_out);
+int album_find_track(Album *a, const char *title);
+int album_reserve(Album *a, int capacity);
 int album_append_song(Album *a, Song *s);
 
 int load_album_from_bin_by_id(int album_id, Album **out);
-int save_album_to_bin(const Album *a);
+int save_album_to_bin(Album *a);
+int delete_album_from_store(Album *a);
+int album_store_snapshot();
+int album_store_commit_snapshot();
+void album_store_discard_snapshot();
+int album_store_reopen();
 void load_all_albums();
 
 void listAlbums();
@@ -0,0 +1,77 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/* Fixed-size object pool. Objects are carved out of large slabs and freed
+ * objects are kept on a free list threaded through the object's own `next`
+ * field (link_offset), so the pool needs no per-object bookkeeping. */
+typedef struct PoolSlab PoolSlab;
+
+typedef struct Pool {
+    const char *name;
+    size_t obj_size;
+    size_t link_offset;
+    size_t objs_per_slab;
+    PoolSlab *slabs;
+    char *bump;
+    size_t bump_left;
+    void *free_list;
+    size_t live;
+    size_t allocs;
+    size_t slab_count;
+} Pool;
+
+#define POOL_INIT(label, type, link_field, per_slab) \
+    { label, sizeof(type), offsetof(type, link_field), per_slab, NULL, NULL, 0, NULL, 0, 0, 0 }
+
+void* pool_alloc(Pool *p);
+void pool_free(Pool *p, void *obj);
+void pool_release_all(Pool *p);
+
+/* Bump allocator for strings that live as long as the library. */
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct StringArena {
+    const char *name;
+    ArenaBlock *blocks;
+    char *cur;
+    size_t left;
+    size_t strings;
+    size_t used;
+    size_t reserved;
+} StringArena;
+
+char* arena_strdup(StringArena *a, const char *s);
+char* arena_strndup(StringArena *a, const char *s, size_t n);
+void arena_release(StringArena *a);
+
+/* Hash-consed strings: one canonical copy of each distinct string, so equal
+ * strings share a pointer and can be compared with ==. New strings are copied
+ * into the backing arena; intern_adopt registers a string that already lives
+ * as long as the library (in an arena or the songs.bin mapping) without
+ * copying it. */
+typedef struct InternSlot InternSlot;
+
+typedef struct StringInterner {
+    const char *name;
+    StringArena *arena;
+    InternSlot *slots;
+    size_t capacity;
+    size_t count;
+    size_t lookups;
+    size_t bytes_saved;
+} StringInterner;
+
+char* intern_strndup(StringInterner *in, const char *s, size_t n);
+char* intern_strdup(StringInterner *in, const char *s);
+char* intern_adopt(StringInterner *in, char *s, size_t n);
+
+extern Pool g_song_pool;
+extern Pool g_playlist_node_pool;
+extern StringArena g_string_arena;
+extern StringInterner g_interner;
+
+void arena_print_stats();
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <stdint.h>
+#include "structures.h"
+
+/* Columnar copy of the song library, one row per song in insertion order
+ * (row 0 is the oldest song, so g_songs position N is row count - N).
+ * String columns point into g_interner, shared with the Song records, so
+ * equal strings are the same pointer; titles and artists are also stored
+ * pre-folded to lower case (interned too) for searching. */
+typedef struct Catalog {
+    int count;
+    int capacity;
+    int *ids;
+    int *years;
+    int *seconds;
+    const char **titles;
+    const char **artists;
+    const char **folded_titles;
+    const char **folded_artists;
+    Song **songs;
+} Catalog;
+
+extern Catalog g_catalog;
+
+int catalog_append(Song *s);
+long catalog_total_seconds();
+int catalog_rows_for_year(int year, int *rows_out);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef CMD_HASH_H
+#define CMD_HASH_H
+
+#include <stdint.h>
+
+/* Seeded FNV-1a over the words of a command name joined by single spaces,
+ * fed one word at a time so the input tokens never need joining. Shared by
+ * tools/gencmd.c, which searches for a seed that makes it collision-free over
+ * the command table, and by dispatchCommand. */
+
+static inline uint32_t cmd_hash_begin(uint32_t seed) {
+    return 2166136261u ^ seed;
+}
+
+static inline uint32_t cmd_hash_word(uint32_t h, const char *word, int first) {
+    if (!first) h = (h ^ (uint32_t)' ') * 16777619u;
+    for (const unsigned char *p = (const unsigned char *)word; *p; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    return h;
+}
+
+static inline uint32_t cmd_hash_end(uint32_t h) {
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef IMPORT_H
+#define IMPORT_H
+
+#include "structures.h"
+
+/* Bulk song import from a CSV or TSV file with one song per line:
+ * title, artist, length (hh:mm:ss), year. The delimiter is a tab if the
+ * first line contains one and a comma otherwise; CSV fields may be quoted
+ * with "" as an escaped quote. A first line whose first field is "title" is
+ * treated as a header. Rows are parsed and validated in parallel, then added
+ * to the library in file order and saved with a single songs.bin rewrite. */
+
+int import_songs_from_file(const char *path);
+
+void importSongs(const char *path);
+void handleImport(Command *cmd);
+
+#endif
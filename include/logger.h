@@ -0,0 +1,31 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stddef.h>
+
+#define COMMAND_LOG_PATH "utils/command_log.txt"
+#define COMMAND_LOG_ROTATED_PATH "utils/command_log.1.txt"
+#define COMMAND_LOG_INDEX_PATH "utils/command_log.idx"
+#define COMMAND_LOG_MAX_BYTES (256 * 1024)
+
+/* Asynchronous command log. log_command copies the line into an in-memory
+ * ring and returns; a background thread appends whatever has accumulated to
+ * COMMAND_LOG_PATH with one write per batch. The fsync policy is taken from
+ * CUNPLUGGED_LOG_FSYNC: "none" (default), "flush" (on log_flush and at
+ * shutdown) or "batch" (after every write).
+ *
+ * COMMAND_LOG_INDEX_PATH holds the byte offset (uint64) of every entry in the
+ * current log, so any range of entries can be read with a few preads. When a
+ * batch would take the log past COMMAND_LOG_MAX_BYTES the log is renamed to
+ * COMMAND_LOG_ROTATED_PATH (replacing the previous one) and a new log and
+ * index are started. */
+
+int log_init();
+void log_command(const char *line);
+void log_flush();
+void log_shutdown();
+
+long log_entry_count();
+int log_read_entries(long first, long last, char **text_out, size_t *len_out);
+
+#endif
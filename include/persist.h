@@ -0,0 +1,38 @@
+#ifndef PERSIST_H
+#define PERSIST_H
+
+#include "structures.h"
+
+/* Write-behind persistence. Album edits only mark the album dirty; dirty
+ * albums are written to the album store once the REPL has been idle for
+ * PERSIST_IDLE_MS, once the oldest pending edit is PERSIST_MAX_DELAY_MS old,
+ * or at exit, so a burst of edits to one album costs one write. Songs added
+ * since the last songs.bin rewrite already sit in the journal; the journal is
+ * compacted on idle once it holds PERSIST_COMPACT_RECORDS songs, and at exit
+ * if it holds any. */
+
+#define PERSIST_IDLE_MS 500
+#define PERSIST_MAX_DELAY_MS 2000
+#define PERSIST_COMPACT_RECORDS 1024
+
+/* SAVE BACKGROUND forks a child that writes a copy-on-write snapshot of the
+ * library to songs.bin and albums.db (both temp files are written before
+ * either is renamed into place) while the REPL carries on. Until the child is reaped the parent leaves both files
+ * alone: album writes stay pending and new songs go to the journal. */
+
+void album_mark_dirty(Album *a);
+void album_forget_dirty(Album *a);
+
+int persist_pending();
+int persist_flush();
+void persist_flush_if_overdue();
+int persist_flush_all();
+
+int persist_save_background();
+int persist_background_running();
+void persist_reap_background(int block);
+
+void saveLibrary(int background);
+void handleSave(Command *cmd);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef POSINDEX_H
+#define POSINDEX_H
+
+#include <stddef.h>
+
+/* Position vector over a prepend-ordered linked list (g_songs, g_albums), so
+ * "song 48213" or "album 12" is an array lookup instead of a walk. Items are
+ * stored oldest first, so position N (1-based from the list head) is
+ * items[count - N] and a prepend is a push.
+ *
+ * The owner keeps a generation counter that it bumps on every change to the
+ * list. Prepends that go through position_index_push keep the vector
+ * current; any other change (a removal) just bumps the generation, and the
+ * vector is rebuilt by walking the list on the next lookup. */
+typedef struct PositionIndex {
+    void **items;
+    int count;
+    int capacity;
+    unsigned long generation;
+} PositionIndex;
+
+void position_index_push(PositionIndex *pi, unsigned long *generation, void *item);
+void* position_index_at(PositionIndex *pi, unsigned long generation,
+                        void *head, size_t next_offset, int position);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "structures.h"
+
+/* Trigram index over the folded titles and artists in g_catalog. Each
+ * trigram maps to the ascending list of catalogue rows containing it. */
+
+int search_index_add(int row);
+int search_rows(const char *query, int **rows_out);
+
+void searchSongs(const char *query);
+void handleSearch(Command *cmd);
+
+#endif
@@ -22,6 +22,7 @@ typedef struct Song {
 typedef struct PlaylistNode {
     Song *song;
     struct PlaylistNode *next;
+    struct PlaylistNode *prev;
 } PlaylistNode;
 
 typedef struct PlaybackState {
@@ -32,11 +33,12 @@ typedef struct PlaybackState {
     int elapsed_seconds;
     int total_seconds;
     int repeat_mode;
-    pid_t playback_pid;
 } PlaybackState;
 
+#define MAX_TOKENS 128
+
 typedef struct Command {
-    char **tokens;
+    char *tokens[MAX_TOKENS];
     int count;
 } Command;
 
@@ -51,15 +53,15 @@ typedef struct CommandDef {
     void (*handler)(Command*);
 } CommandDef;
 
-typedef struct AlbumNode {
-    Song *song;
-    struct AlbumNode *next;
-} AlbumNode;
-
 typedef struct Album {
     char *name;
     int album_id;
-    AlbumNode *head;
+    int store_slot;
+    int dirty;
+    Song **tracks;
+    int track_count;
+    int track_capacity;
+    long total_seconds;
     struct Album *next;
     struct Album *prev;
 } Album;
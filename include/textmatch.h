@@ -0,0 +1,19 @@
+#ifndef TEXTMATCH_H
+#define TEXTMATCH_H
+
+#include <stddef.h>
+
+/* ASCII case-folding kernels. Bytes outside 'A'..'Z' are compared as-is, which
+ * matches strcasecmp in the C locale. The implementation (AVX2, SSE2 or
+ * scalar) is picked once at first use based on the running CPU. */
+
+void ascii_fold(char *dst, const char *src, size_t n);
+char* ascii_fold_dup(const char *src);
+
+int ascii_casecmp_eq(const char *a, const char *b);
+int ascii_equals_folded(const char *s, size_t n, const char *folded);
+long ascii_find_folded(const char *haystack, size_t hay_len, const char *needle_folded, size_t needle_len);
+
+const char* textmatch_impl_name();
+
+#endif
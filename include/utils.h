@@ -4,9 +4,11 @@
 #include "structures.h"
 
 #define MAX_LINE 1024
-#define MAX_TOKENS 128
+#define LOG_PAGE_SIZE 20
+#define LOG_TAIL_SIZE 10
 
 extern CommandDef commands[];
+extern int g_batch_mode;
 
 Command parseCommand(char *line);
 void freeCommand(Command *cmd);
@@ -20,10 +22,16 @@ void playsong(const char *songname);
 void handlePlay(Command *cmd);
 void listSongs();
 void handleListSongs(Command *cmd);
-void showLog();
+void listSongsByYear(int year);
+void handleListYear(Command *cmd);
+void showLog(long from, long to);
+void showLogPage(long page);
+void showLogTail();
 void handleLog(Command *cmd);
 void exitProgram();
 void handleExit(Command *cmd);
+void showStats();
+void handleStats(Command *cmd);
 void stopPlay();
 void handleStop(Command *cmd);
 
@@ -0,0 +1,350 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include "include/logger.h"
+
+#define LOG_RING_SIZE (64 * 1024)
+#define LOG_INDEX_BATCH 512
+
+typedef enum LogFsyncPolicy {
+    LOG_FSYNC_NONE,
+    LOG_FSYNC_FLUSH,
+    LOG_FSYNC_BATCH
+} LogFsyncPolicy;
+
+/* head and tail are running byte counts; the ring holds [head, tail). The
+ * REPL only writes past tail and the writer only reads below tail, so the
+ * writer can issue its write without holding the lock. */
+static char g_log_ring[LOG_RING_SIZE];
+static size_t g_log_head = 0;
+static size_t g_log_tail = 0;
+static int g_log_writing = 0;
+static int g_log_stop = 0;
+
+static pthread_mutex_t g_log_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_log_has_data = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_log_drained = PTHREAD_COND_INITIALIZER;
+static pthread_t g_log_thread;
+static int g_log_started = 0;
+static int g_log_fd = -1;
+static LogFsyncPolicy g_log_fsync = LOG_FSYNC_NONE;
+
+/* Owned by the writer thread once it is running; the REPL only reads them
+ * after log_flush has seen the writer go idle. */
+static int g_index_fd = -1;
+static uint64_t g_log_size = 0;
+static long g_index_count = 0;
+
+static LogFsyncPolicy fsync_policy_from_env() {
+    const char *policy = getenv("CUNPLUGGED_LOG_FSYNC");
+    if (!policy || strcmp(policy, "none") == 0) return LOG_FSYNC_NONE;
+    if (strcmp(policy, "flush") == 0) return LOG_FSYNC_FLUSH;
+    if (strcmp(policy, "batch") == 0) return LOG_FSYNC_BATCH;
+    fprintf(stderr, "Unknown CUNPLUGGED_LOG_FSYNC '%s', using 'none'\n", policy);
+    return LOG_FSYNC_NONE;
+}
+
+static int write_all(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void index_append(const uint64_t *offsets, size_t count) {
+    if (count == 0) return;
+    if (write_all(g_index_fd, offsets, count * sizeof(uint64_t)) != 0) {
+        perror("Failed to write command log index");
+        return;
+    }
+    g_index_count += (long)count;
+}
+
+/* Indexes every line that starts in buf, which holds the log from byte base
+ * onwards; first_is_start says whether buf[0] begins a line. */
+static void index_scan(const char *buf, size_t len, uint64_t base, int first_is_start) {
+    uint64_t offsets[LOG_INDEX_BATCH];
+    size_t n = 0;
+    if (first_is_start && len > 0) offsets[n++] = base;
+    for (size_t i = 0; i + 1 < len; i++) {
+        if (buf[i] != '\n') continue;
+        offsets[n++] = base + i + 1;
+        if (n == LOG_INDEX_BATCH) {
+            index_append(offsets, n);
+            n = 0;
+        }
+    }
+    index_append(offsets, n);
+}
+
+/* Brings the index up to date with the log after a crash between the log
+ * write and the index write: entries are re-derived from the last indexed
+ * offset onwards, or from the start if the index does not match the log. */
+static void index_repair() {
+    struct stat st;
+    if (fstat(g_log_fd, &st) != 0) return;
+    g_log_size = (uint64_t)st.st_size;
+
+    long count = 0;
+    uint64_t last = 0;
+    if (fstat(g_index_fd, &st) == 0) count = (long)(st.st_size / sizeof(uint64_t));
+    if (count > 0) {
+        char before = '\n';
+        if (pread(g_index_fd, &last, sizeof(last), (off_t)(count - 1) * sizeof(uint64_t)) != sizeof(last) ||
+            last >= g_log_size ||
+            (last > 0 && pread(g_log_fd, &before, 1, (off_t)last - 1) != 1) ||
+            before != '\n') {
+            count = 0;
+            last = 0;
+        }
+    }
+    if (ftruncate(g_index_fd, (off_t)count * sizeof(uint64_t)) != 0) {
+        perror("Failed to repair command log index");
+        return;
+    }
+    g_index_count = count;
+
+    char buf[64 * 1024];
+    uint64_t pos = last;
+    int first_is_start = (count == 0);
+    /* Lines are found by the newline before them, so a chunk boundary that
+     * falls right after a newline must still index the next line. */
+    while (pos < g_log_size) {
+        ssize_t n = pread(g_log_fd, buf, sizeof(buf), (off_t)pos);
+        if (n <= 0) break;
+        size_t len = (size_t)n;
+        if (len > 1 && pos + len < g_log_size && buf[len - 1] == '\n') len--;
+        index_scan(buf, len, pos, first_is_start);
+        first_is_start = 0;
+        pos += len;
+    }
+}
+
+/* Starts a fresh log, keeping the current one as the single rotated copy. */
+static void rotate_log() {
+    if (rename(COMMAND_LOG_PATH, COMMAND_LOG_ROTATED_PATH) != 0) {
+        perror("Failed to rotate command log");
+        return;
+    }
+    int fd = open(COMMAND_LOG_PATH, O_RDWR | O_APPEND | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror("Failed to open command log");
+        return;
+    }
+    close(g_log_fd);
+    g_log_fd = fd;
+    g_log_size = 0;
+    if (ftruncate(g_index_fd, 0) != 0) perror("Failed to reset command log index");
+    g_index_count = 0;
+}
+
+/* Writes everything between head and tail, retrying short writes. */
+static void write_pending(size_t head, size_t tail) {
+    while (head < tail) {
+        size_t start = head % LOG_RING_SIZE;
+        size_t len = tail - head;
+        struct iovec iov[2];
+        int iovcnt = 1;
+
+        iov[0].iov_base = g_log_ring + start;
+        if (start + len > LOG_RING_SIZE) {
+            iov[0].iov_len = LOG_RING_SIZE - start;
+            iov[1].iov_base = g_log_ring;
+            iov[1].iov_len = len - iov[0].iov_len;
+            iovcnt = 2;
+        } else {
+            iov[0].iov_len = len;
+        }
+
+        ssize_t n = writev(g_log_fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("Failed to write command log");
+            return;
+        }
+        head += (size_t)n;
+    }
+}
+
+/* Appends one batch of whole entries to the log and their offsets to the
+ * index, rotating first if the batch would overflow the size limit. */
+static void write_batch(size_t head, size_t tail) {
+    size_t len = tail - head;
+    if (g_log_size > 0 && g_log_size + len > COMMAND_LOG_MAX_BYTES) rotate_log();
+
+    write_pending(head, tail);
+
+    size_t start = head % LOG_RING_SIZE;
+    if (start + len > LOG_RING_SIZE) {
+        size_t first = LOG_RING_SIZE - start;
+        index_scan(g_log_ring + start, first, g_log_size, 1);
+        index_scan(g_log_ring, len - first, g_log_size + first, g_log_ring[LOG_RING_SIZE - 1] == '\n');
+    } else {
+        index_scan(g_log_ring + start, len, g_log_size, 1);
+    }
+    g_log_size += len;
+}
+
+static void* log_writer(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&g_log_lock);
+    for (;;) {
+        while (g_log_head == g_log_tail && !g_log_stop) {
+            pthread_cond_wait(&g_log_has_data, &g_log_lock);
+        }
+        if (g_log_head == g_log_tail && g_log_stop) break;
+
+        size_t head = g_log_head, tail = g_log_tail;
+        g_log_writing = 1;
+        pthread_mutex_unlock(&g_log_lock);
+
+        write_batch(head, tail);
+        if (g_log_fsync == LOG_FSYNC_BATCH) {
+            fsync(g_log_fd);
+            fsync(g_index_fd);
+        }
+
+        pthread_mutex_lock(&g_log_lock);
+        g_log_head = tail;
+        g_log_writing = 0;
+        pthread_cond_broadcast(&g_log_drained);
+    }
+    pthread_mutex_unlock(&g_log_lock);
+    return NULL;
+}
+
+int log_init() {
+    if (g_log_started) return 0;
+
+    g_log_fsync = fsync_policy_from_env();
+    g_log_fd = open(COMMAND_LOG_PATH, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (g_log_fd < 0) {
+        perror("Failed to open command log");
+        return -1;
+    }
+    g_index_fd = open(COMMAND_LOG_INDEX_PATH, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (g_index_fd < 0) {
+        perror("Failed to open command log index");
+        close(g_log_fd);
+        g_log_fd = -1;
+        return -1;
+    }
+    index_repair();
+
+    g_log_stop = 0;
+    if (pthread_create(&g_log_thread, NULL, log_writer, NULL) != 0) {
+        perror("Failed to start log writer");
+        close(g_log_fd);
+        close(g_index_fd);
+        g_log_fd = -1;
+        g_index_fd = -1;
+        return -1;
+    }
+    g_log_started = 1;
+    return 0;
+}
+
+void log_command(const char *line) {
+    if (!g_log_started || !line) return;
+
+    size_t len = strlen(line);
+    if (len + 1 > LOG_RING_SIZE) len = LOG_RING_SIZE - 1;
+
+    pthread_mutex_lock(&g_log_lock);
+    while (LOG_RING_SIZE - (g_log_tail - g_log_head) < len + 1) {
+        pthread_cond_wait(&g_log_drained, &g_log_lock);
+    }
+
+    size_t start = g_log_tail % LOG_RING_SIZE;
+    size_t first = len < LOG_RING_SIZE - start ? len : LOG_RING_SIZE - start;
+    memcpy(g_log_ring + start, line, first);
+    memcpy(g_log_ring, line + first, len - first);
+    g_log_ring[(g_log_tail + len) % LOG_RING_SIZE] = '\n';
+    g_log_tail += len + 1;
+
+    pthread_cond_signal(&g_log_has_data);
+    pthread_mutex_unlock(&g_log_lock);
+}
+
+void log_flush() {
+    if (!g_log_started) return;
+
+    pthread_mutex_lock(&g_log_lock);
+    while (g_log_head != g_log_tail || g_log_writing) {
+        pthread_cond_wait(&g_log_drained, &g_log_lock);
+    }
+    pthread_mutex_unlock(&g_log_lock);
+
+    if (g_log_fsync != LOG_FSYNC_NONE) {
+        fsync(g_log_fd);
+        fsync(g_index_fd);
+    }
+}
+
+void log_shutdown() {
+    if (!g_log_started) return;
+
+    log_flush();
+
+    pthread_mutex_lock(&g_log_lock);
+    g_log_stop = 1;
+    pthread_cond_signal(&g_log_has_data);
+    pthread_mutex_unlock(&g_log_lock);
+
+    pthread_join(g_log_thread, NULL);
+    close(g_log_fd);
+    close(g_index_fd);
+    g_log_fd = -1;
+    g_index_fd = -1;
+    g_log_started = 0;
+}
+
+long log_entry_count() {
+    if (!g_log_started) return 0;
+    log_flush();
+    return g_index_count;
+}
+
+/* Reads entries first..last (1-based, inclusive) into a malloc'd buffer of
+ * newline-terminated lines. The caller clamps the range with
+ * log_entry_count. */
+int log_read_entries(long first, long last, char **text_out, size_t *len_out) {
+    if (!g_log_started || first < 1 || last < first || last > g_index_count) return -1;
+
+    uint64_t start, end = g_log_size;
+    if (pread(g_index_fd, &start, sizeof(start), (off_t)(first - 1) * sizeof(uint64_t)) != sizeof(start)) return -1;
+    if (last < g_index_count &&
+        pread(g_index_fd, &end, sizeof(end), (off_t)last * sizeof(uint64_t)) != sizeof(end)) return -1;
+    if (end < start) return -1;
+
+    size_t len = (size_t)(end - start);
+    char *text = malloc(len + 1);
+    if (!text) return -1;
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = pread(g_log_fd, text + got, len - got, (off_t)(start + got));
+        if (n <= 0) {
+            free(text);
+            return -1;
+        }
+        got += (size_t)n;
+    }
+    text[len] = '\0';
+    *text_out = text;
+    *len_out = len;
+    return 0;
+}
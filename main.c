@@ -2,21 +2,34 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <time.h>
 #include "include/utils.h"
 #include "include/songs.h"
 #include "include/albums.h"
+#include "include/logger.h"
+#include "include/persist.h"
+#include <poll.h>
 
-void logCommandToFile(const char *command) {
-    FILE *logFile = fopen("utils/command_log.txt", "a");
-    if (logFile != NULL) {
-        fprintf(logFile, "%s\n", command);
-        fclose(logFile);
-    }
+static double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1000.0 + (end->tv_nsec - start->tv_nsec) / 1e6;
 }
 
-int main() {
+int main(int argc, char *argv[]) {
     char line[MAX_LINE];
     
+    if (argc == 3 && strcmp(argv[1], "--batch") == 0) {
+        if (!freopen(argv[2], "r", stdin)) {
+            perror(argv[2]);
+            return 1;
+        }
+        g_batch_mode = 1;
+    } else if (argc != 1) {
+        fprintf(stderr, "Usage: %s [--batch <file>]\n", argv[0]);
+        return 1;
+    } else if (!isatty(STDIN_FILENO)) {
+        g_batch_mode = 1;
+    }
+    
     printf("C-Unplugged\n\n");
     
     init_playback_state();
@@ -27,12 +40,30 @@ int main() {
     printf("Loading albums...\n");
     load_all_albums();
     
+    log_init();
+    
     printf("\nType 'HELP' or '1' for available commands.\n");
     printf("TIP: Use song/album IDs OR names in commands!\n\n");
     
+    // In batch mode each command's run time goes to stderr as
+    // "[n] COMMAND: ms", followed by a total at the end.
+    long batch_commands = 0;
+    struct timespec batch_start, cmd_start, cmd_end;
+    clock_gettime(CLOCK_MONOTONIC, &batch_start);
+    
     while (1) {
-        printf("> ");
-        fflush(stdout);
+        persist_reap_background(0);
+        
+        if (!g_batch_mode) {
+            printf("> ");
+            fflush(stdout);
+            
+            // Write pending changes once the user has paused typing
+            if (persist_pending()) {
+                struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+                if (poll(&pfd, 1, PERSIST_IDLE_MS) == 0) persist_flush();
+            }
+        }
         
         if (fgets(line, sizeof(line), stdin) == NULL) {
             break;
@@ -44,7 +75,7 @@ int main() {
             continue;
         }
         
-        logCommandToFile(line);
+        log_command(line);
         
         Command cmd = parseCommand(line);
         
@@ -53,17 +84,27 @@ int main() {
             break;
         }
         
+        clock_gettime(CLOCK_MONOTONIC, &cmd_start);
         dispatchCommand(&cmd);
+        clock_gettime(CLOCK_MONOTONIC, &cmd_end);
+        persist_flush_if_overdue();
+        
+        if (g_batch_mode && cmd.count > 0) {
+            batch_commands++;
+            fprintf(stderr, "[%ld] %s: %.3f ms\n", batch_commands, cmd.tokens[0], elapsed_ms(&cmd_start, &cmd_end));
+        }
         freeCommand(&cmd);
     }
     
-    cleanup_playback_state();
-    save_all_songs_to_bin();
-    
-    for (Album *a = g_albums; a; a = a->next) {
-        save_album_to_bin(a);
+    if (g_batch_mode) {
+        clock_gettime(CLOCK_MONOTONIC, &cmd_end);
+        fprintf(stderr, "Batch: %ld commands in %.3f ms\n", batch_commands, elapsed_ms(&batch_start, &cmd_end));
     }
     
+    cleanup_playback_state();
+    log_shutdown();
+    persist_flush_all();
+    
     printf("\nGoodbye!\n");
     return 0;
 }
\ No newline at end of file
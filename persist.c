@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "include/persist.h"
+#include "include/albums.h"
+#include "include/songs.h"
+
+static Album **g_dirty_albums = NULL;
+static int g_dirty_count = 0;
+static int g_dirty_capacity = 0;
+static int64_t g_dirty_since_ms = 0;
+
+/* Exit statuses of the background save child. */
+#define BGSAVE_OK 0
+#define BGSAVE_FAILED 1
+#define BGSAVE_SONGS_ONLY 2
+
+static pid_t g_bgsave_pid = -1;
+static int g_bgsave_journal_mark = 0;
+static int64_t g_bgsave_started_ms = 0;
+
+static int64_t monotonic_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void album_mark_dirty(Album *a) {
+    if (!a || a->dirty) return;
+
+    if (g_dirty_count == g_dirty_capacity) {
+        int cap = g_dirty_capacity ? g_dirty_capacity * 2 : 16;
+        Album **grown = realloc(g_dirty_albums, cap * sizeof(Album*));
+        if (!grown) {
+            /* Fall back to writing through rather than losing the edit. */
+            save_album_to_bin(a);
+            return;
+        }
+        g_dirty_albums = grown;
+        g_dirty_capacity = cap;
+    }
+
+    if (g_dirty_count == 0) g_dirty_since_ms = monotonic_ms();
+    g_dirty_albums[g_dirty_count++] = a;
+    a->dirty = 1;
+}
+
+/* Drops a pending write for an album that is about to be freed. */
+void album_forget_dirty(Album *a) {
+    if (!a || !a->dirty) return;
+    for (int i = 0; i < g_dirty_count; i++) {
+        if (g_dirty_albums[i] == a) {
+            g_dirty_albums[i] = g_dirty_albums[--g_dirty_count];
+            break;
+        }
+    }
+    a->dirty = 0;
+}
+
+int persist_pending() {
+    return g_dirty_count > 0 || songs_journal_records() >= PERSIST_COMPACT_RECORDS;
+}
+
+/* Writes every dirty album once and compacts a large journal. Albums that
+ * fail to save stay queued for the next flush. Returns the number of albums
+ * written. */
+int persist_flush() {
+    persist_reap_background(0);
+    if (g_bgsave_pid > 0) return 0;
+
+    int written = 0;
+    int kept = 0;
+    for (int i = 0; i < g_dirty_count; i++) {
+        Album *a = g_dirty_albums[i];
+        if (save_album_to_bin(a) == 0) {
+            a->dirty = 0;
+            written++;
+        } else {
+            printf("Error! Could not save album \"%s\"; it will be retried.\n", a->name);
+            g_dirty_albums[kept++] = a;
+        }
+    }
+    g_dirty_count = kept;
+    if (kept > 0) g_dirty_since_ms = monotonic_ms();
+
+    if (songs_journal_records() >= PERSIST_COMPACT_RECORDS) compact_songs_journal();
+    return written;
+}
+
+void persist_flush_if_overdue() {
+    if (g_dirty_count > 0 && monotonic_ms() - g_dirty_since_ms >= PERSIST_MAX_DELAY_MS) persist_flush();
+}
+
+/* Shutdown: flush dirty albums and fold any journal into songs.bin.
+ * Unchanged albums and an unchanged library are not rewritten. */
+int persist_flush_all() {
+    persist_reap_background(1);
+    int written = persist_flush();
+    if (g_dirty_count > 0) {
+        printf("Error! %d album%s could not be saved.\n", g_dirty_count, g_dirty_count == 1 ? "" : "s");
+    }
+    compact_songs_journal();
+    return written;
+}
+
+int persist_background_running() {
+    return g_bgsave_pid > 0;
+}
+
+int persist_save_background() {
+    if (g_bgsave_pid > 0) {
+        printf("A background save is already running.\n");
+        return -1;
+    }
+
+    fflush(stdout);
+    int mark = songs_journal_records();
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork failed");
+        return -1;
+    }
+    if (pid == 0) {
+        /* Both files are written before either is renamed into place, so a
+         * failed save leaves the previous pair untouched. Only a failed
+         * rename of albums.db, after songs.bin has been replaced, exits
+         * with BGSAVE_SONGS_ONLY. */
+        if (save_songs_snapshot() < 0) _exit(BGSAVE_FAILED);
+        if (album_store_snapshot() != 0) {
+            discard_songs_snapshot();
+            _exit(BGSAVE_FAILED);
+        }
+        if (commit_songs_snapshot() != 0) {
+            album_store_discard_snapshot();
+            _exit(BGSAVE_FAILED);
+        }
+        _exit(album_store_commit_snapshot() == 0 ? BGSAVE_OK : BGSAVE_SONGS_ONLY);
+    }
+
+    g_bgsave_pid = pid;
+    g_bgsave_journal_mark = mark;
+    g_bgsave_started_ms = monotonic_ms();
+    return 0;
+}
+
+/* Collects a finished background save, reports it, and takes the new files
+ * over. With block set, waits for a running save to finish. */
+void persist_reap_background(int block) {
+    if (g_bgsave_pid <= 0) return;
+
+    int status;
+    pid_t r;
+    do {
+        r = waitpid(g_bgsave_pid, &status, block ? 0 : WNOHANG);
+    } while (r < 0 && errno == EINTR);
+    if (r == 0) return;
+
+    int result = r > 0 && WIFEXITED(status) ? WEXITSTATUS(status) : BGSAVE_FAILED;
+    g_bgsave_pid = -1;
+
+    if (result == BGSAVE_OK || result == BGSAVE_SONGS_ONLY) {
+        songs_snapshot_committed(g_bgsave_journal_mark);
+    }
+    if (result == BGSAVE_OK) {
+        printf("Background save finished in %lld ms.\n",
+               (long long)(monotonic_ms() - g_bgsave_started_ms));
+    } else if (result == BGSAVE_SONGS_ONLY) {
+        printf("Background save failed; songs.bin was saved but albums.db is unchanged.\n");
+    } else {
+        printf("Background save failed; the previous files are unchanged.\n");
+    }
+
+    /* Picks up the new albums.db if the child replaced it. */
+    album_store_reopen();
+    persist_flush();
+}
+
+void saveLibrary(int background) {
+    if (background) {
+        if (persist_save_background() == 0) {
+            printf("Background save started.\n");
+        }
+        return;
+    }
+
+    persist_reap_background(1);
+    int songs = save_all_songs_to_bin();
+    persist_flush();
+    if (songs < 0) {
+        printf("Failed to save the song library.\n");
+        return;
+    }
+    if (g_dirty_count > 0) {
+        printf("Saved %d songs; %d album%s could not be saved.\n",
+               songs, g_dirty_count, g_dirty_count == 1 ? "" : "s");
+        return;
+    }
+    printf("Saved %d songs and all album changes.\n", songs);
+}
+
+void handleSave(Command *cmd) {
+    if (cmd->count == 1) {
+        saveLibrary(0);
+        return;
+    }
+    if (cmd->count == 2 && strcmp(cmd->tokens[1], "BACKGROUND") == 0) {
+        saveLibrary(1);
+        return;
+    }
+    printf("Error! Invalid command format.\n");
+    printf("Usage: SAVE [BACKGROUND]\n");
+}
@@ -0,0 +1,52 @@
+#include <stdlib.h>
+#include "include/posindex.h"
+
+static int position_index_reserve(PositionIndex *pi, int capacity) {
+    if (capacity <= pi->capacity) return 0;
+    int new_cap = pi->capacity ? pi->capacity : 256;
+    while (new_cap < capacity) new_cap *= 2;
+    void **items = realloc(pi->items, new_cap * sizeof(void*));
+    if (!items) return -1;
+    pi->items = items;
+    pi->capacity = new_cap;
+    return 0;
+}
+
+/* Records a prepend of item. The vector stays current only if it already
+ * was; otherwise the next lookup rebuilds it. */
+void position_index_push(PositionIndex *pi, unsigned long *generation, void *item) {
+    int current = pi->generation == *generation;
+    (*generation)++;
+    if (!current || position_index_reserve(pi, pi->count + 1) != 0) return;
+    pi->items[pi->count++] = item;
+    pi->generation = *generation;
+}
+
+static int position_index_rebuild(PositionIndex *pi, void *head, size_t next_offset) {
+    int count = 0;
+    for (char *p = head; p; p = *(char**)(p + next_offset)) count++;
+    if (position_index_reserve(pi, count) != 0) return -1;
+
+    int i = count;
+    for (char *p = head; p; p = *(char**)(p + next_offset)) pi->items[--i] = p;
+    pi->count = count;
+    return 0;
+}
+
+/* Item at 1-based position from the list head, or NULL if out of range. */
+void* position_index_at(PositionIndex *pi, unsigned long generation,
+                        void *head, size_t next_offset, int position) {
+    if (pi->generation != generation) {
+        if (position_index_rebuild(pi, head, next_offset) != 0) {
+            /* Out of memory: fall back to walking the list. */
+            int idx = 1;
+            for (char *p = head; p; p = *(char**)(p + next_offset), idx++) {
+                if (idx == position) return p;
+            }
+            return NULL;
+        }
+        pi->generation = generation;
+    }
+    if (position < 1 || position > pi->count) return NULL;
+    return pi->items[pi->count - position];
+}
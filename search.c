@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "include/search.h"
+#include "include/catalog.h"
+#include "include/textmatch.h"
+
+#define SEARCH_MAX_RESULTS 50
+
+typedef struct Posting {
+    uint32_t key;
+    int count;
+    int capacity;
+    int *rows;
+} Posting;
+
+/* Open-addressing table of trigram postings; key 0 marks an empty slot, so
+ * stored keys are the packed trigram plus one. */
+static Posting *g_postings = NULL;
+static size_t g_posting_capacity = 0;
+static size_t g_posting_used = 0;
+
+static uint32_t trigram_key(const char *p) {
+    return (((uint32_t)(unsigned char)p[0] << 16) |
+            ((uint32_t)(unsigned char)p[1] << 8) |
+            (uint32_t)(unsigned char)p[2]) + 1;
+}
+
+static size_t hash_key(uint32_t key) {
+    return (size_t)(key * 2654435761u);
+}
+
+static Posting* posting_find(uint32_t key) {
+    if (!g_posting_capacity) return NULL;
+    size_t mask = g_posting_capacity - 1;
+    for (size_t i = hash_key(key) & mask; g_postings[i].key; i = (i + 1) & mask) {
+        if (g_postings[i].key == key) return &g_postings[i];
+    }
+    return NULL;
+}
+
+static int posting_grow() {
+    size_t new_cap = g_posting_capacity ? g_posting_capacity * 2 : 4096;
+    Posting *table = calloc(new_cap, sizeof(Posting));
+    if (!table) return -1;
+    for (size_t i = 0; i < g_posting_capacity; i++) {
+        if (!g_postings[i].key) continue;
+        size_t j = hash_key(g_postings[i].key) & (new_cap - 1);
+        while (table[j].key) j = (j + 1) & (new_cap - 1);
+        table[j] = g_postings[i];
+    }
+    free(g_postings);
+    g_postings = table;
+    g_posting_capacity = new_cap;
+    return 0;
+}
+
+static Posting* posting_get_or_create(uint32_t key) {
+    Posting *p = posting_find(key);
+    if (p) return p;
+    if ((g_posting_used + 1) * 4 > g_posting_capacity * 3 && posting_grow() != 0) return NULL;
+
+    size_t mask = g_posting_capacity - 1;
+    size_t i = hash_key(key) & mask;
+    while (g_postings[i].key) i = (i + 1) & mask;
+    g_postings[i].key = key;
+    g_posting_used++;
+    return &g_postings[i];
+}
+
+static int posting_add(uint32_t key, int row) {
+    Posting *p = posting_get_or_create(key);
+    if (!p) return -1;
+    /* Rows arrive in ascending order, so a repeat trigram is always last. */
+    if (p->count > 0 && p->rows[p->count - 1] == row) return 0;
+    if (p->count == p->capacity) {
+        int new_cap = p->capacity ? p->capacity * 2 : 4;
+        int *grown = realloc(p->rows, new_cap * sizeof(int));
+        if (!grown) return -1;
+        p->rows = grown;
+        p->capacity = new_cap;
+    }
+    p->rows[p->count++] = row;
+    return 0;
+}
+
+static int index_string(const char *folded, int row) {
+    size_t len = strlen(folded);
+    for (size_t i = 0; i + 3 <= len; i++) {
+        if (posting_add(trigram_key(folded + i), row) != 0) return -1;
+    }
+    return 0;
+}
+
+int search_index_add(int row) {
+    if (row < 0 || row >= g_catalog.count) return -1;
+    if (index_string(g_catalog.folded_titles[row], row) != 0) return -1;
+    return index_string(g_catalog.folded_artists[row], row);
+}
+
+/* Remembers whether the last artist scanned contained the query. Artists are
+ * interned, so rows by the same artist are recognised by pointer and their
+ * artist is scanned once per search rather than once per row. */
+typedef struct ArtistMatch {
+    const char *artist;
+    int matches;
+} ArtistMatch;
+
+static int row_matches(int row, const char *folded_query, size_t len, ArtistMatch *last) {
+    const char *title = g_catalog.folded_titles[row];
+    if (ascii_find_folded(title, strlen(title), folded_query, len) >= 0) return 1;
+
+    const char *artist = g_catalog.folded_artists[row];
+    if (artist != last->artist) {
+        last->artist = artist;
+        last->matches = ascii_find_folded(artist, strlen(artist), folded_query, len) >= 0;
+    }
+    return last->matches;
+}
+
+/* Collects matching rows, newest first, into a malloc'd array. Title prefix
+ * matches are listed before other matches. Returns the number of rows. */
+int search_rows(const char *query, int **rows_out) {
+    *rows_out = NULL;
+    if (!query || !*query || g_catalog.count == 0) return 0;
+
+    char *folded = ascii_fold_dup(query);
+    if (!folded) return 0;
+    size_t len = strlen(folded);
+
+    const int *candidates = NULL;
+    int candidate_count = g_catalog.count;
+    if (len >= 3) {
+        for (size_t i = 0; i + 3 <= len; i++) {
+            Posting *p = posting_find(trigram_key(folded + i));
+            if (!p) {
+                free(folded);
+                return 0;
+            }
+            if (!candidates || p->count < candidate_count) {
+                candidates = p->rows;
+                candidate_count = p->count;
+            }
+        }
+    }
+
+    int *rows = malloc((candidate_count ? candidate_count : 1) * sizeof(int));
+    if (!rows) {
+        free(folded);
+        return 0;
+    }
+
+    int matched = 0;
+    ArtistMatch last = { NULL, 0 };
+    for (int i = candidate_count - 1; i >= 0; i--) {
+        int row = candidates ? candidates[i] : i;
+        if (row_matches(row, folded, len, &last)) rows[matched++] = row;
+    }
+
+    /* Stable partition: title prefix matches first. */
+    int *ordered = malloc((matched ? matched : 1) * sizeof(int));
+    if (ordered) {
+        int n = 0;
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < matched; i++) {
+                const char *title = g_catalog.folded_titles[rows[i]];
+                int is_prefix = strncmp(title, folded, len) == 0;
+                if (is_prefix == (pass == 0)) ordered[n++] = rows[i];
+            }
+        }
+        free(rows);
+        rows = ordered;
+    }
+
+    free(folded);
+    *rows_out = rows;
+    return matched;
+}
+
+void searchSongs(const char *query) {
+    int *rows = NULL;
+    int matched = search_rows(query, &rows);
+
+    printf("\nSEARCH RESULTS FOR \"%s\":\n", query);
+    if (matched == 0) {
+        printf("No songs found.\n\n");
+        free(rows);
+        return;
+    }
+
+    int shown = matched < SEARCH_MAX_RESULTS ? matched : SEARCH_MAX_RESULTS;
+    for (int i = 0; i < shown; i++) {
+        int row = rows[i];
+        int secs = g_catalog.seconds[row];
+        printf("%d. %s - %s (%02d:%02d:%02d, %d)\n",
+               g_catalog.count - row,
+               g_catalog.titles[row],
+               g_catalog.artists[row],
+               secs / 3600, (secs % 3600) / 60, secs % 60,
+               g_catalog.years[row]);
+    }
+    if (matched > shown) printf("... and %d more\n", matched - shown);
+    printf("\n%d match%s.\n\n", matched, matched == 1 ? "" : "es");
+    free(rows);
+}
+
+void handleSearch(Command *cmd) {
+    if (cmd->count != 2) {
+        printf("Error! Invalid command format.\n");
+        printf("Usage: SEARCH <text>\n");
+        return;
+    }
+    searchSongs(cmd->tokens[1]);
+}
@@ -1,26 +1,45 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <strings.h>
+#include <ctype.h>
+#include <errno.h>
 #include <unistd.h>
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <time.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include "include/songs.h"
 #include "include/utils.h"
 #include "include/albums.h"
+#include "include/arena.h"
+#include "include/catalog.h"
+#include "include/search.h"
+#include "include/textmatch.h"
+#include "include/persist.h"
+#include "include/posindex.h"
+
+#define SONGS_BIN_PATH "utils/songs.bin"
+#define SONGS_JOURNAL_PATH "utils/songs.journal"
 
 Song *g_songs = NULL;
 PlaybackState g_playback;
 int g_next_song_id = 1;
 
-volatile sig_atomic_t pause_requested = 0;
-volatile sig_atomic_t resume_requested = 0;
-volatile sig_atomic_t next_requested = 0;
-volatile sig_atomic_t prev_requested = 0;
-volatile sig_atomic_t repeat_requested = 0;
-volatile sig_atomic_t loop_requested = 0;
+/* Serial numbers of g_songs; songs are only ever prepended. */
+static PositionIndex g_song_positions;
+static unsigned long g_songs_generation = 0;
 
 int parse_length(const char *s, SongLength *out) {
     if (!s || !out) return -1;
@@ -47,18 +66,10 @@ long length_to_seconds(const SongLength *len) {
 
 int song_init(Song *s, const char *title, const char *artist, const char *length_str, int year) {
     if (!s || !title || !artist || !length_str) return -1;
-    s->title = strdup(title);
-    s->artist = strdup(artist);
-    if (!s->title || !s->artist) {
-        free(s->title);
-        free(s->artist);
-        return -1;
-    }
-    if (parse_length(length_str, &s->length) != 0) {
-        free(s->title);
-        free(s->artist);
-        return -1;
-    }
+    if (parse_length(length_str, &s->length) != 0) return -1;
+    s->title = intern_strdup(&g_interner, title);
+    s->artist = intern_strdup(&g_interner, artist);
+    if (!s->title || !s->artist) return -1;
     s->year = year;
     s->song_id = g_next_song_id++;
     s->next = NULL;
@@ -66,14 +77,30 @@ int song_init(Song *s, const char *title, const char *artist, const char *length
     return 0;
 }
 
+/* Song strings are interned in g_interner, so songs with the same artist or
+ * title share one copy. The copies live either in g_string_arena or in the
+ * private mapping of songs.bin (version 2), which is copy-on-write, never
+ * written back and kept until exit. Both outlive the song, so song_free only
+ * detaches them. */
+
+Song* song_alloc() {
+    Song *s = pool_alloc(&g_song_pool);
+    if (s) memset(s, 0, sizeof(Song));
+    return s;
+}
+
 void song_free(Song *s) {
     if (!s) return;
-    free(s->title);
     s->title = NULL;
-    free(s->artist);
     s->artist = NULL;
 }
 
+void song_release(Song *s) {
+    if (!s) return;
+    song_free(s);
+    pool_free(&g_song_pool, s);
+}
+
 void song_print(const Song *s) {
     if (!s) return;
     char buf[16];
@@ -84,23 +111,98 @@ void song_print(const Song *s) {
            buf);
 }
 
+/* Open-addressing indexes over g_songs, kept in sync by add_song_to_library and
+ * load_all_songs_from_bin. Slots hold Song pointers; duplicate titles occupy
+ * separate slots along the same probe chain, in insertion order. */
+typedef struct SongIndex {
+    Song **slots;
+    size_t capacity;
+    size_t used;
+} SongIndex;
+
+static SongIndex g_id_index;
+static SongIndex g_title_index;
+
+static size_t hash_song_id(int id) {
+    return (size_t)((unsigned int)id * 2654435761u);
+}
+
+static size_t hash_title(const char *title) {
+    size_t h = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)title; *p; p++) {
+        h ^= (size_t)tolower(*p);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static size_t song_index_hash(const SongIndex *idx, const Song *s) {
+    return idx == &g_id_index ? hash_song_id(s->song_id) : hash_title(s->title);
+}
+
+static void song_index_place(SongIndex *idx, Song *s) {
+    size_t mask = idx->capacity - 1;
+    size_t i = song_index_hash(idx, s) & mask;
+    while (idx->slots[i]) i = (i + 1) & mask;
+    idx->slots[i] = s;
+    idx->used++;
+}
+
+static int song_index_grow(SongIndex *idx) {
+    size_t new_cap = idx->capacity ? idx->capacity * 2 : 64;
+    Song **old = idx->slots;
+    size_t old_cap = idx->capacity;
+
+    idx->slots = calloc(new_cap, sizeof(Song*));
+    if (!idx->slots) {
+        idx->slots = old;
+        return -1;
+    }
+    idx->capacity = new_cap;
+    idx->used = 0;
+
+    if (old) {
+        /* Start just past an empty slot so no cluster is split across the
+         * wrap-around; that keeps duplicate titles in insertion order. */
+        size_t start = 0;
+        while (old[start]) start++;
+        for (size_t k = 1; k <= old_cap; k++) {
+            Song *s = old[(start + k) & (old_cap - 1)];
+            if (s) song_index_place(idx, s);
+        }
+        free(old);
+    }
+    return 0;
+}
+
+static int song_index_insert(SongIndex *idx, Song *s) {
+    if ((idx->used + 1) * 4 > idx->capacity * 3 && song_index_grow(idx) != 0) return -1;
+    song_index_place(idx, s);
+    return 0;
+}
+
+static void song_index_add(Song *s) {
+    if (!s || !s->title) return;
+    song_index_insert(&g_id_index, s);
+    song_index_insert(&g_title_index, s);
+}
+
 Song* find_song_by_number(int number) {
     if (number <= 0) return NULL;
-    int idx = 1;
-    for (Song *s = g_songs; s; s = s->next, idx++) {
-        if (idx == number) return s;
-    }
-    return NULL;
+    return position_index_at(&g_song_positions, g_songs_generation,
+                             g_songs, offsetof(Song, next), number);
 }
 
 Song** find_all_songs_by_title(const char *title, int *count) {
     if (!title || !count) return NULL;
 
     *count = 0;
-    for (Song *s = g_songs; s; s = s->next) {
-        if (s->title && strcasecmp(s->title, title) == 0) {
-            (*count)++;
-        }
+    if (!g_title_index.capacity) return NULL;
+
+    size_t mask = g_title_index.capacity - 1;
+    size_t home = hash_title(title) & mask;
+    for (size_t i = home; g_title_index.slots[i]; i = (i + 1) & mask) {
+        if (ascii_casecmp_eq(g_title_index.slots[i]->title, title)) (*count)++;
     }
 
     if (*count == 0) return NULL;
@@ -111,10 +213,11 @@ Song** find_all_songs_by_title(const char *title, int *count) {
         return NULL;
     }
 
-    int idx = 0;
-    for (Song *s = g_songs; s; s = s->next) {
-        if (s->title && strcasecmp(s->title, title) == 0) {
-            matches[idx++] = s;
+    /* Probe order is oldest first; g_songs is newest first, so fill backwards. */
+    int idx = *count;
+    for (size_t i = home; g_title_index.slots[i]; i = (i + 1) & mask) {
+        if (ascii_casecmp_eq(g_title_index.slots[i]->title, title)) {
+            matches[--idx] = g_title_index.slots[i];
         }
     }
 
@@ -122,8 +225,10 @@ Song** find_all_songs_by_title(const char *title, int *count) {
 }
 
 Song* find_song_by_id(int id) {
-    for (Song *s = g_songs; s; s = s->next) {
-        if (s->song_id == id) return s;
+    if (!g_id_index.capacity) return NULL;
+    size_t mask = g_id_index.capacity - 1;
+    for (size_t i = hash_song_id(id) & mask; g_id_index.slots[i]; i = (i + 1) & mask) {
+        if (g_id_index.slots[i]->song_id == id) return g_id_index.slots[i];
     }
     return NULL;
 }
@@ -163,6 +268,13 @@ Song* find_song_by_title_interactive(const char *title) {
         return result;
     }
 
+    if (g_batch_mode) {
+        Song *result = matches[0];
+        free(matches);
+        printf("Multiple songs found with title '%s', using: %s — %s\n", title, result->title, result->artist);
+        return result;
+    }
+
     printf("\nMultiple songs found with title '%s':\n", title);
     for (int i = 0; i < count; i++) {
         char buf[16];
@@ -189,147 +301,692 @@ Song* find_song_by_title_interactive(const char *title) {
     return result;
 }
 
-int load_all_songs_from_bin() {
-    FILE *fp = fopen("utils/songs.bin", "rb");
-    if (!fp) {
-        printf("No songs.bin found. Starting with empty library.\n");
-        return 0;
+/* Set when songs.bin must not be rewritten: it is corrupt and could not be
+ * moved aside, or the library was only partly loaded. */
+static int g_songs_bin_disabled = 0;
+
+/* Links s at the head of the library. Its catalogue row is taken first, so
+ * listings that number songs by catalogue row stay in step with g_songs; if
+ * that fails nothing is linked and the caller still owns s. */
+static int library_link_song(Song *s) {
+    int row = catalog_append(s);
+    if (row < 0) return -1;
+
+    s->next = g_songs;
+    s->prev = NULL;
+    if (g_songs) g_songs->prev = s;
+    g_songs = s;
+    position_index_push(&g_song_positions, &g_songs_generation, s);
+    song_index_add(s);
+    search_index_add(row);
+    if (s->song_id >= g_next_song_id) g_next_song_id = s->song_id + 1;
+    return 0;
+}
+
+/* A song read from disk could not be linked, so the library in memory is
+ * missing some; songs.bin and the journal are left as they are. */
+static void library_load_failed(Song *s) {
+    song_release(s);
+    if (!g_songs_bin_disabled) {
+        printf("Error! Out of memory loading songs; songs.bin will not be rewritten this session.\n");
     }
+    g_songs_bin_disabled = 1;
+}
 
-    int count = 0;
-    while (1) {
-        int title_len;
-        if (fread(&title_len, sizeof(int), 1, fp) != 1) break;
+/* songs.journal holds songs added since the last compaction, one frame per
+ * song: [uint32 payload_len][payload][uint32 checksum]. The payload uses the
+ * original (pre-version-2) songs.bin record layout. A torn or corrupt trailing frame is cut
+ * off on replay. */
+static int g_journal_fd = -1;
+static int g_journal_records = 0;
+/* Journal length before the last append, so that record can be taken back. */
+static off_t g_journal_undo_offset = -1;
+
+static uint32_t journal_checksum(const unsigned char *p, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static size_t song_record_size(const Song *s) {
+    return 2 * sizeof(int) + strlen(s->title) + strlen(s->artist) +
+           sizeof(SongLength) + 2 * sizeof(int);
+}
+
+static void song_record_encode(const Song *s, unsigned char *buf) {
+    int title_len = (int)strlen(s->title);
+    int artist_len = (int)strlen(s->artist);
+    unsigned char *p = buf;
+    memcpy(p, &title_len, sizeof(int)); p += sizeof(int);
+    memcpy(p, s->title, title_len); p += title_len;
+    memcpy(p, &artist_len, sizeof(int)); p += sizeof(int);
+    memcpy(p, s->artist, artist_len); p += artist_len;
+    memcpy(p, &s->length, sizeof(SongLength)); p += sizeof(SongLength);
+    memcpy(p, &s->year, sizeof(int)); p += sizeof(int);
+    memcpy(p, &s->song_id, sizeof(int));
+}
+
+static Song* song_record_decode(const unsigned char *p, size_t len) {
+    const unsigned char *end = p + len;
+    int title_len, artist_len;
+
+    if ((size_t)(end - p) < sizeof(int)) return NULL;
+    memcpy(&title_len, p, sizeof(int)); p += sizeof(int);
+    if (title_len < 0 || end - p < title_len) return NULL;
+    const unsigned char *title = p; p += title_len;
+
+    if ((size_t)(end - p) < sizeof(int)) return NULL;
+    memcpy(&artist_len, p, sizeof(int)); p += sizeof(int);
+    if (artist_len < 0 || end - p < artist_len) return NULL;
+    const unsigned char *artist = p; p += artist_len;
+
+    if ((size_t)(end - p) != sizeof(SongLength) + 2 * sizeof(int)) return NULL;
 
-        char *title = malloc(title_len + 1);
-        if (!title) break;
-        if (fread(title, 1, title_len, fp) != (size_t)title_len) {
-            free(title);
+    Song *s = song_alloc();
+    if (!s) return NULL;
+    s->title = intern_strndup(&g_interner, (const char *)title, title_len);
+    s->artist = intern_strndup(&g_interner, (const char *)artist, artist_len);
+    if (!s->title || !s->artist) {
+        song_release(s);
+        return NULL;
+    }
+    memcpy(&s->length, p, sizeof(SongLength)); p += sizeof(SongLength);
+    memcpy(&s->year, p, sizeof(int)); p += sizeof(int);
+    memcpy(&s->song_id, p, sizeof(int));
+    return s;
+}
+
+static int replay_songs_journal() {
+    FILE *fp = fopen(SONGS_JOURNAL_PATH, "rb");
+    if (!fp) return 0;
+
+    int replayed = 0;
+    long good_offset = 0;
+    unsigned char *buf = NULL;
+
+    while (1) {
+        uint32_t len, checksum;
+        if (fread(&len, sizeof(len), 1, fp) != 1) break;
+        unsigned char *grown = realloc(buf, len ? len : 1);
+        if (!grown) break;
+        buf = grown;
+        if (fread(buf, 1, len, fp) != len) break;
+        if (fread(&checksum, sizeof(checksum), 1, fp) != 1) break;
+        if (journal_checksum(buf, len) != checksum) break;
+
+        Song *s = song_record_decode(buf, len);
+        if (!s) break;
+        good_offset = ftell(fp);
+        g_journal_records++;
+
+        /* A record may already be in songs.bin if we crashed mid-compaction. */
+        if (find_song_by_id(s->song_id)) {
+            song_release(s);
+            continue;
+        }
+        if (library_link_song(s) != 0) {
+            library_load_failed(s);
             break;
         }
-        title[title_len] = '\0';
+        replayed++;
+    }
 
-        int artist_len;
-        if (fread(&artist_len, sizeof(int), 1, fp) != 1) {
-            free(title);
-            break;
+    fseek(fp, 0, SEEK_END);
+    if (ftell(fp) != good_offset) {
+        printf("Discarding torn tail of songs journal.\n");
+        if (truncate(SONGS_JOURNAL_PATH, good_offset) != 0) {
+            perror("Failed to truncate songs journal");
         }
+    }
+
+    free(buf);
+    fclose(fp);
+    return replayed;
+}
+
+static int append_song_to_journal(const Song *s) {
+    if (g_journal_fd < 0) {
+        g_journal_fd = open(SONGS_JOURNAL_PATH, O_WRONLY | O_APPEND | O_CREAT, 0644);
+        if (g_journal_fd < 0) {
+            perror("Failed to open songs journal");
+            return -1;
+        }
+    }
 
-        char *artist = malloc(artist_len + 1);
-        if (!artist) { free(title); break; }
-        if (fread(artist, 1, artist_len, fp) != (size_t)artist_len) {
-            free(title);
-            free(artist);
+    g_journal_undo_offset = lseek(g_journal_fd, 0, SEEK_END);
+
+    uint32_t len = (uint32_t)song_record_size(s);
+    size_t frame_len = sizeof(uint32_t) + len + sizeof(uint32_t);
+    unsigned char *frame = malloc(frame_len);
+    if (!frame) return -1;
+
+    song_record_encode(s, frame + sizeof(uint32_t));
+    uint32_t checksum = journal_checksum(frame + sizeof(uint32_t), len);
+    memcpy(frame, &len, sizeof(uint32_t));
+    memcpy(frame + sizeof(uint32_t) + len, &checksum, sizeof(uint32_t));
+
+    ssize_t written = write(g_journal_fd, frame, frame_len);
+    free(frame);
+    if (written != (ssize_t)frame_len) {
+        perror("Failed to append to songs journal");
+        return -1;
+    }
+    g_journal_records++;
+    return 0;
+}
+
+/* Removes the record written by the last append_song_to_journal. */
+static void drop_last_journal_record() {
+    if (g_journal_fd < 0 || g_journal_undo_offset < 0) return;
+    if (ftruncate(g_journal_fd, g_journal_undo_offset) != 0) {
+        perror("Failed to truncate songs journal");
+        return;
+    }
+    g_journal_undo_offset = -1;
+    g_journal_records--;
+}
+
+/* On-disk layout of songs.bin version 2:
+ *   SongBinHeader
+ *   SongBinEntry[count]      fixed-size records, oldest song first
+ *   string area              NUL-terminated titles and artists
+ * Entry string offsets are relative to the start of the string area.
+ * Files without the magic are the original record stream and are still read;
+ * they get rewritten in this format at the next compaction. */
+#define SONGS_BIN_MAGIC "CUSB"
+#define SONGS_BIN_VERSION 2
+
+typedef struct SongBinHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+} SongBinHeader;
+
+typedef struct SongBinEntry {
+    int32_t song_id;
+    int32_t year;
+    int32_t hh, mm, ss;
+    uint32_t title_off;
+    uint32_t artist_off;
+    uint32_t reserved;
+} SongBinEntry;
+
+static int g_songs_bin_legacy = 0;
+
+/* Returns the number of songs loaded, -1 if the file is not in the mapped
+ * format, or -2 if it claims to be but is malformed. */
+static int load_songs_mapped(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SongBinHeader)) return -1;
+
+    size_t size = (size_t)st.st_size;
+    char *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return -1;
+
+    const SongBinHeader *hdr = (const SongBinHeader *)map;
+    if (memcmp(hdr->magic, SONGS_BIN_MAGIC, 4) != 0) {
+        munmap(map, size);
+        return -1;
+    }
+
+    /* Compare against size without adding header fields, which could wrap. */
+    if (hdr->version != SONGS_BIN_VERSION ||
+        hdr->count > (size - sizeof(SongBinHeader)) / sizeof(SongBinEntry) ||
+        hdr->strings_offset < sizeof(SongBinHeader) + (size_t)hdr->count * sizeof(SongBinEntry) ||
+        hdr->strings_offset > size ||
+        hdr->strings_size != size - hdr->strings_offset ||
+        (hdr->strings_size > 0 && map[size - 1] != '\0')) {
+        munmap(map, size);
+        return -2;
+    }
+
+    const SongBinEntry *entries = (const SongBinEntry *)(map + sizeof(SongBinHeader));
+    char *strings = map + hdr->strings_offset;
+    int count = 0;
+    for (uint32_t i = 0; i < hdr->count; i++) {
+        const SongBinEntry *e = &entries[i];
+        if (e->title_off >= hdr->strings_size || e->artist_off >= hdr->strings_size) continue;
+
+        Song *s = song_alloc();
+        if (!s) break;
+        char *title = strings + e->title_off;
+        char *artist = strings + e->artist_off;
+        s->title = intern_adopt(&g_interner, title, strlen(title));
+        s->artist = intern_adopt(&g_interner, artist, strlen(artist));
+        if (!s->title || !s->artist) {
+            song_release(s);
             break;
         }
-        artist[artist_len] = '\0';
+        s->length.hh = e->hh;
+        s->length.mm = e->mm;
+        s->length.ss = e->ss;
+        s->year = e->year;
+        s->song_id = e->song_id;
+        if (library_link_song(s) != 0) {
+            library_load_failed(s);
+            break;
+        }
+        count++;
+    }
+    return count;
+}
+
+static int load_songs_legacy(FILE *fp) {
+    int count = 0;
+    char *scratch = NULL;
+    size_t scratch_cap = 0;
+
+    while (1) {
+        int title_len, artist_len;
+        if (fread(&title_len, sizeof(int), 1, fp) != 1 || title_len < 0) break;
+        if ((size_t)title_len + 1 > scratch_cap) {
+            char *grown = realloc(scratch, title_len + 1);
+            if (!grown) break;
+            scratch = grown;
+            scratch_cap = title_len + 1;
+        }
+        if (fread(scratch, 1, title_len, fp) != (size_t)title_len) break;
+        char *title = intern_strndup(&g_interner, scratch, title_len);
+
+        if (fread(&artist_len, sizeof(int), 1, fp) != 1 || artist_len < 0) break;
+        if ((size_t)artist_len + 1 > scratch_cap) {
+            char *grown = realloc(scratch, artist_len + 1);
+            if (!grown) break;
+            scratch = grown;
+            scratch_cap = artist_len + 1;
+        }
+        if (fread(scratch, 1, artist_len, fp) != (size_t)artist_len) break;
+        char *artist = intern_strndup(&g_interner, scratch, artist_len);
 
         SongLength len;
         int year, song_id;
         if (fread(&len, sizeof(SongLength), 1, fp) != 1 ||
             fread(&year, sizeof(int), 1, fp) != 1 ||
             fread(&song_id, sizeof(int), 1, fp) != 1) {
-            free(title);
-            free(artist);
             break;
         }
 
-        Song *s = malloc(sizeof(Song));
-        if (!s) { free(title); free(artist); break; }
+        Song *s = song_alloc();
+        if (!s || !title || !artist) break;
         s->title = title;
         s->artist = artist;
         s->length = len;
         s->year = year;
         s->song_id = song_id;
-        s->next = g_songs;
-        s->prev = NULL;
-
-        if (g_songs) g_songs->prev = s;
-        g_songs = s;
-
-        if (song_id >= g_next_song_id) g_next_song_id = song_id + 1;
+        if (library_link_song(s) != 0) {
+            library_load_failed(s);
+            break;
+        }
 
         count++;
     }
-
-    fclose(fp);
-    printf("Loaded %d songs from library.\n", count);
+    free(scratch);
     return count;
 }
 
-int save_all_songs_to_bin() {
-    FILE *fp = fopen("utils/songs.bin", "wb");
+int load_all_songs_from_bin() {
+    int count = 0;
+    int fd = open(SONGS_BIN_PATH, O_RDONLY);
+    if (fd < 0) {
+        printf("No songs.bin found. Starting with empty library.\n");
+    } else {
+        count = load_songs_mapped(fd);
+        if (count == -1) {
+            FILE *fp = fdopen(fd, "rb");
+            if (fp) {
+                count = load_songs_legacy(fp);
+                fclose(fp);
+            } else {
+                close(fd);
+                count = 0;
+            }
+            g_songs_bin_legacy = 1;
+        } else {
+            close(fd);
+            /* Set the damaged file aside so the next rewrite cannot
+             * replace it with whatever is left in memory. */
+            if (count == -2) {
+                if (rename(SONGS_BIN_PATH, SONGS_BIN_PATH ".corrupt") == 0) {
+                    printf("Error! songs.bin is corrupt; moved it to %s. Starting with empty library.\n",
+                           SONGS_BIN_PATH ".corrupt");
+                } else {
+                    perror("Failed to move aside songs.bin");
+                    printf("Error! songs.bin is corrupt; new songs will only be kept in the journal.\n");
+                    g_songs_bin_disabled = 1;
+                }
+                count = 0;
+            }
+        }
+    }
+
+    int replayed = replay_songs_journal();
+    if (replayed > 0) printf("Replayed %d songs from journal.\n", replayed);
+
+    printf("Loaded %d songs from library.\n", count + replayed);
+    return count + replayed;
+}
+
+/* Offsets of the strings already placed in the string area being written,
+ * keyed by interned pointer so each distinct string is stored once. */
+typedef struct StringOffsets {
+    const char **keys;
+    uint32_t *offs;
+    size_t mask;
+} StringOffsets;
+
+static int string_offsets_init(StringOffsets *m, size_t expected) {
+    size_t cap = 64;
+    while (cap < expected * 2) cap *= 2;
+    m->keys = calloc(cap, sizeof(char*));
+    m->offs = malloc(cap * sizeof(uint32_t));
+    m->mask = cap - 1;
+    return (m->keys && m->offs) ? 0 : -1;
+}
+
+static void string_offsets_free(StringOffsets *m) {
+    free(m->keys);
+    free(m->offs);
+}
+
+/* Returns the offset of s, placing it at *next if it is new. */
+static uint32_t string_offsets_place(StringOffsets *m, const char *s, uint64_t *next) {
+    size_t i = ((uintptr_t)s >> 3) * 0x9E3779B97F4A7C15ULL >> 20 & m->mask;
+    for (; m->keys[i]; i = (i + 1) & m->mask) {
+        if (m->keys[i] == s) return m->offs[i];
+    }
+    m->keys[i] = s;
+    m->offs[i] = (uint32_t)*next;
+    *next += strlen(s) + 1;
+    return m->offs[i];
+}
+
+/* Writes g_songs to tmp_path, ready to be renamed over songs.bin. Leaves the
+ * journal alone. */
+static int write_songs_bin(const char *tmp_path) {
+    if (g_songs_bin_disabled) return -1;
+
+    /* Write oldest first so that loading (which prepends) restores list order. */
+    Song *tail = NULL;
+    SongBinHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SONGS_BIN_MAGIC, 4);
+    hdr.version = SONGS_BIN_VERSION;
+    for (Song *s = g_songs; s; s = s->next) {
+        tail = s;
+        if (!s->title || !s->artist) continue;
+        hdr.count++;
+    }
+    hdr.strings_offset = sizeof(SongBinHeader) + (uint64_t)hdr.count * sizeof(SongBinEntry);
+
+    /* Interned strings are shared between songs, so the string area holds
+     * each distinct title and artist once. */
+    StringOffsets offsets;
+    SongBinEntry *entries = malloc((hdr.count ? hdr.count : 1) * sizeof(SongBinEntry));
+    if (string_offsets_init(&offsets, (size_t)hdr.count * 2) != 0 || !entries) {
+        string_offsets_free(&offsets);
+        free(entries);
+        return -1;
+    }
+
+    uint32_t n = 0;
+    for (Song *s = tail; s; s = s->prev) {
+        if (!s->title || !s->artist) continue;
+        SongBinEntry *e = &entries[n++];
+        memset(e, 0, sizeof(*e));
+        e->song_id = s->song_id;
+        e->year = s->year;
+        e->hh = s->length.hh;
+        e->mm = s->length.mm;
+        e->ss = s->length.ss;
+        e->title_off = string_offsets_place(&offsets, s->title, &hdr.strings_size);
+        e->artist_off = string_offsets_place(&offsets, s->artist, &hdr.strings_size);
+    }
+    string_offsets_free(&offsets);
+
+    FILE *fp = fopen(tmp_path, "wb");
     if (!fp) {
         perror("Failed to open songs.bin for writing");
+        free(entries);
         return -1;
     }
 
+    fwrite(&hdr, sizeof(hdr), 1, fp);
+    fwrite(entries, sizeof(SongBinEntry), n, fp);
+
+    /* A string's first use is the one whose offset is the next free one. */
+    uint64_t written = 0;
     int count = 0;
-    for (Song *s = g_songs; s; s = s->next) {
+    for (Song *s = tail; s; s = s->prev) {
         if (!s->title || !s->artist) continue;
+        const SongBinEntry *e = &entries[count++];
+        if (e->title_off == written) {
+            fwrite(s->title, 1, strlen(s->title) + 1, fp);
+            written += strlen(s->title) + 1;
+        }
+        if (e->artist_off == written) {
+            fwrite(s->artist, 1, strlen(s->artist) + 1, fp);
+            written += strlen(s->artist) + 1;
+        }
+    }
+    free(entries);
+
+    /* A short fwrite only sets the stream error, so check it before the
+     * temp file can replace songs.bin. */
+    if (ferror(fp) || fflush(fp) != 0 || fsync(fileno(fp)) != 0) {
+        perror("Failed to write songs.bin");
+        fclose(fp);
+        remove(tmp_path);
+        return -1;
+    }
+    if (fclose(fp) != 0) {
+        perror("Failed to write songs.bin");
+        remove(tmp_path);
+        return -1;
+    }
+    return count;
+}
 
-        int title_len = (int)strlen(s->title);
-        int artist_len = (int)strlen(s->artist);
-
-        fwrite(&title_len, sizeof(int), 1, fp);
-        fwrite(s->title, 1, title_len, fp);
-        fwrite(&artist_len, sizeof(int), 1, fp);
-        fwrite(s->artist, 1, artist_len, fp);
-        fwrite(&s->length, sizeof(SongLength), 1, fp);
-        fwrite(&s->year, sizeof(int), 1, fp);
-        fwrite(&s->song_id, sizeof(int), 1, fp);
-        count++;
+static int replace_songs_bin(const char *tmp_path) {
+    if (rename(tmp_path, SONGS_BIN_PATH) != 0) {
+        perror("Failed to replace songs.bin");
+        remove(tmp_path);
+        return -1;
     }
+    return 0;
+}
 
-    fclose(fp);
+int save_all_songs_to_bin() {
+    int count = write_songs_bin(SONGS_BIN_PATH ".tmp");
+    if (count < 0 || replace_songs_bin(SONGS_BIN_PATH ".tmp") != 0) return -1;
+
+    /* Everything in the journal is now part of songs.bin. */
+    if (g_journal_fd >= 0) {
+        close(g_journal_fd);
+        g_journal_fd = -1;
+    }
+    remove(SONGS_JOURNAL_PATH);
+    g_journal_records = 0;
+    g_songs_bin_legacy = 0;
     return count;
 }
 
+int songs_journal_records() {
+    return g_journal_records;
+}
+
+/* Run in the background save child: writes the library as of the fork to a
+ * snapshot file, which commit_songs_snapshot then renames over songs.bin or
+ * discard_songs_snapshot removes. */
+int save_songs_snapshot() {
+    return write_songs_bin(SONGS_BIN_PATH ".snapshot");
+}
+
+int commit_songs_snapshot() {
+    return replace_songs_bin(SONGS_BIN_PATH ".snapshot");
+}
+
+void discard_songs_snapshot() {
+    remove(SONGS_BIN_PATH ".snapshot");
+}
+
+/* Called in the parent once a snapshot taken when the journal held
+ * records_at_fork records is in place. Those records are now in songs.bin;
+ * any added since stay in the journal, and replay skips the rest by id. */
+void songs_snapshot_committed(int records_at_fork) {
+    g_songs_bin_legacy = 0;
+    if (g_journal_records > records_at_fork) {
+        g_journal_records -= records_at_fork;
+        return;
+    }
+    if (g_journal_fd >= 0) {
+        close(g_journal_fd);
+        g_journal_fd = -1;
+    }
+    remove(SONGS_JOURNAL_PATH);
+    g_journal_records = 0;
+}
+
+int compact_songs_journal() {
+    if (g_journal_records == 0 && !g_songs_bin_legacy) return 0;
+    return save_all_songs_to_bin();
+}
+
 int add_song_to_library(Song *s) {
     if (!s) return -1;
 
-    s->next = g_songs;
-    s->prev = NULL;
-    if (g_songs) g_songs->prev = s;
-    g_songs = s;
+    if (append_song_to_journal(s) != 0) return -1;
+    if (library_link_song(s) != 0) {
+        drop_last_journal_record();
+        return -1;
+    }
+    return 0;
+}
 
-    save_all_songs_to_bin();
+/* Adds songs (already numbered) in order and persists them with one
+ * songs.bin rewrite rather than a journal record each. If the rewrite fails,
+ * or a background save owns songs.bin, they are journalled instead so they
+ * still survive a restart. If memory runs out part way, the songs not yet
+ * added are released and *count is cut to the number that were. */
+int add_songs_to_library(Song **songs, int *count) {
+    int linked = 0;
+    while (linked < *count && library_link_song(songs[linked]) == 0) linked++;
+    for (int i = linked; i < *count; i++) song_release(songs[i]);
+    *count = linked;
+    if (linked == 0) return 0;
+    if (!persist_background_running() && save_all_songs_to_bin() >= 0) return 0;
+
+    int rc = persist_background_running() ? 0 : -1;
+    for (int i = 0; i < linked; i++) {
+        if (append_song_to_journal(songs[i]) != 0) rc = -1;
+    }
+    return rc;
+}
+
+/* Playback runs on one long-lived thread that shares g_playback with the
+ * REPL. Playlist edits take g_playback_lock directly; transport controls go
+ * through a single-producer/single-consumer ring (REPL -> player), so the
+ * REPL never blocks on the player to issue them.
+ *
+ * The player sleeps in poll() on a timerfd armed for the next whole second of
+ * the current track (an absolute CLOCK_MONOTONIC deadline) and on an eventfd
+ * that the REPL signals whenever it queues a command or releases the lock, so
+ * controls apply as soon as they are issued. Elapsed time is derived from the
+ * monotonic clock rather than counted ticks, so it does not drift. */
+typedef enum PlayerCommand {
+    PLAYER_PAUSE,
+    PLAYER_RESUME,
+    PLAYER_NEXT,
+    PLAYER_PREV,
+    PLAYER_REPEAT,
+    PLAYER_LOOP,
+    PLAYER_QUIT
+} PlayerCommand;
+
+#define PLAYER_QUEUE_SIZE 64
+
+static PlayerCommand g_player_queue[PLAYER_QUEUE_SIZE];
+static atomic_uint g_player_queue_head;
+static atomic_uint g_player_queue_tail;
+
+static pthread_mutex_t g_playback_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t g_player_thread;
+static int g_player_started = 0;
+static int g_player_event_fd = -1;
+static int g_player_timer_fd = -1;
+
+#define NS_PER_SEC 1000000000LL
+
+/* Playback clock, guarded by g_playback_lock: the monotonic time at which the
+ * current track was at 0:00, and whether the clock is running. While it is
+ * stopped, g_clock_stopped_ns records when it stopped so the origin can be
+ * shifted by the length of the pause. */
+static int64_t g_track_origin_ns = 0;
+static int64_t g_clock_stopped_ns = 0;
+static int g_clock_running = 0;
+
+static int64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+static void player_wake() {
+    if (g_player_event_fd < 0) return;
+    uint64_t one = 1;
+    ssize_t n = write(g_player_event_fd, &one, sizeof(one));
+    (void)n;
+}
+
+void playback_lock() { pthread_mutex_lock(&g_playback_lock); }
+
+/* The REPL may have changed what is playing while it held the lock, so let the
+ * player re-sync its clock and timer. */
+void playback_unlock() {
+    pthread_mutex_unlock(&g_playback_lock);
+    player_wake();
+}
+
+static int player_send(PlayerCommand cmd) {
+    unsigned tail = atomic_load_explicit(&g_player_queue_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&g_player_queue_head, memory_order_acquire);
+    if (tail - head == PLAYER_QUEUE_SIZE) return -1;
+    g_player_queue[tail % PLAYER_QUEUE_SIZE] = cmd;
+    atomic_store_explicit(&g_player_queue_tail, tail + 1, memory_order_release);
+    player_wake();
     return 0;
 }
 
-void handle_pause_signal(int sig) { pause_requested = 1; }
-void handle_resume_signal(int sig) { resume_requested = 1; }
-void handle_next_signal(int sig) { next_requested = 1; }
-void handle_prev_signal(int sig) { prev_requested = 1; }
-void handle_repeat_signal(int sig) { repeat_requested = 1; }
-void handle_loop_signal(int sig) { loop_requested = 1; }
+static int player_receive(PlayerCommand *out) {
+    unsigned head = atomic_load_explicit(&g_player_queue_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&g_player_queue_tail, memory_order_acquire);
+    if (head == tail) return 0;
+    *out = g_player_queue[head % PLAYER_QUEUE_SIZE];
+    atomic_store_explicit(&g_player_queue_head, head + 1, memory_order_release);
+    return 1;
+}
 
 void init_playback_state() {
     memset(&g_playback, 0, sizeof(PlaybackState));
-    g_playback.playback_pid = -1;
+    g_clock_running = 0;
 }
 
 void cleanup_playback_state() {
-    if (g_playback.playback_pid > 0) {
-        kill(g_playback.playback_pid, SIGKILL);
-        waitpid(g_playback.playback_pid, NULL, 0);
-    }
+    stop_playback_thread();
 
-    if (g_playback.head) {
-        PlaylistNode *start = g_playback.head;
-        PlaylistNode *curr = g_playback.head;
-        do {
-            PlaylistNode *next = curr->next;
-            free(curr);
-            curr = next;
-        } while (curr && curr != start);
-    }
+    pool_release_all(&g_playlist_node_pool);
+    g_playback.head = NULL;
+    g_playback.current = NULL;
 }
 
 void make_playlist_circular() {
     if (g_playback.head) {
-        PlaylistNode *tail = g_playback.head;
-        while (tail->next && tail->next != g_playback.head) tail = tail->next;
+        PlaylistNode *tail = g_playback.head->prev;
         tail->next = g_playback.head;
     }
 }
@@ -341,17 +998,20 @@ int playlist_insert_after_current(Song *songs[], int count) {
     if (!insert_point) insert_point = g_playback.head;
 
     for (int i = 0; i < count; i++) {
-        PlaylistNode *node = malloc(sizeof(PlaylistNode));
+        PlaylistNode *node = pool_alloc(&g_playlist_node_pool);
         if (!node) return -1;
         node->song = songs[i];
 
         if (!g_playback.head) {
             g_playback.head = node;
             node->next = node;
+            node->prev = node;
             g_playback.current = node;
             insert_point = node;
         } else {
             node->next = insert_point->next;
+            node->prev = insert_point;
+            insert_point->next->prev = node;
             insert_point->next = node;
             insert_point = node;
         }
@@ -387,130 +1047,225 @@ void display_progress_bar() {
     fflush(stdout);
 }
 
-void playback_loop() {
-    signal(SIGUSR1, handle_pause_signal);
-    signal(SIGUSR2, handle_resume_signal);
-    signal(SIGCONT, handle_next_signal);
-    signal(SIGTERM, handle_prev_signal);
-    signal(SIGURG, handle_repeat_signal);
-    signal(SIGIO, handle_loop_signal);
+/* Makes node the current track, starting at 0:00 at monotonic time origin_ns.
+ * Passing the previous track's end time instead of "now" keeps back-to-back
+ * tracks free of accumulated scheduling delay. */
+static void set_current_track_at(PlaylistNode *node, int64_t origin_ns) {
+    g_playback.current = node;
+    g_playback.elapsed_seconds = 0;
+    if (node && node->song) {
+        g_playback.total_seconds = (int)length_to_seconds(&node->song->length);
+    }
+    g_track_origin_ns = origin_ns;
+    if (!g_clock_running) g_clock_stopped_ns = origin_ns;
+}
 
-    while (1) {
-        if (pause_requested) { g_playback.is_paused = 1; pause_requested = 0; }
-        if (resume_requested) { g_playback.is_paused = 0; resume_requested = 0; }
+static void set_current_track(PlaylistNode *node) {
+    set_current_track_at(node, monotonic_ns());
+}
 
-        if (repeat_requested) {
-            if (g_playback.repeat_mode == 1) {
-                g_playback.repeat_mode = 0;
-                printf("\n⟲ Repeat mode: OFF\n");
-            } else {
-                g_playback.repeat_mode = 1;
-                printf("\n⟲ Repeat mode: ON (current song will repeat once)\n");
-            }
-            repeat_requested = 0;
-        }
+/* Starts or stops the clock to match the playback state. Returns 1 if it
+ * changed. */
+static int clock_sync(int64_t now) {
+    int should_run = g_playback.is_playing && !g_playback.is_paused && g_playback.current;
+    if (should_run == g_clock_running) return 0;
+    if (should_run) g_track_origin_ns += now - g_clock_stopped_ns;
+    else g_clock_stopped_ns = now;
+    g_clock_running = should_run;
+    return 1;
+}
 
-        if (loop_requested) {
-            g_playback.repeat_mode = 2;
-            printf("\n⟳ Loop mode: ON (current song will repeat forever)\n");
-            loop_requested = 0;
+/* Applies one transport command; called with g_playback_lock held. Returns 0
+ * when the player should stop. */
+static int player_apply(PlayerCommand cmd) {
+    switch (cmd) {
+    case PLAYER_PAUSE:
+        g_playback.is_paused = 1;
+        break;
+    case PLAYER_RESUME:
+        g_playback.is_paused = 0;
+        break;
+    case PLAYER_REPEAT:
+        if (g_playback.repeat_mode == 1) {
+            g_playback.repeat_mode = 0;
+            printf("\n⟲ Repeat mode: OFF\n");
+        } else {
+            g_playback.repeat_mode = 1;
+            printf("\n⟲ Repeat mode: ON (current song will repeat once)\n");
+        }
+        break;
+    case PLAYER_LOOP:
+        g_playback.repeat_mode = 2;
+        printf("\n⟳ Loop mode: ON (current song will repeat forever)\n");
+        break;
+    case PLAYER_NEXT:
+        if (g_playback.current && g_playback.current->next) {
+            set_current_track(g_playback.current->next);
+            printf("\n");
+        }
+        break;
+    case PLAYER_PREV:
+        if (g_playback.head && g_playback.current) {
+            set_current_track(g_playback.current->prev);
+            printf("\n");
         }
+        break;
+    case PLAYER_QUIT:
+        return 0;
+    }
+    return 1;
+}
 
-        if (next_requested) {
-            if (g_playback.current && g_playback.current->next) {
-                g_playback.current = g_playback.current->next;
-                g_playback.elapsed_seconds = 0;
-                if (g_playback.current->song) {
-                    g_playback.total_seconds = (int)length_to_seconds(&g_playback.current->song->length);
-                    printf("\n");
-                }
+/* Advances the playback position to now, moving through as many track ends
+ * as have passed. */
+static void player_tick(int64_t now) {
+    if (!g_clock_running) return;
+
+    if (!g_playback.current->song && g_playback.current->next != g_playback.current) {
+        set_current_track_at(g_playback.current->next, g_track_origin_ns);
+    }
+
+    for (;;) {
+        int length = g_playback.total_seconds > 0 ? g_playback.total_seconds : 1;
+        int64_t track_end = g_track_origin_ns + length * NS_PER_SEC;
+        if (now < track_end) break;
+
+        if (g_playback.repeat_mode == 1) {
+            g_track_origin_ns = track_end;
+            g_playback.repeat_mode = 0;
+            printf("\n⟲ Repeating song once\n");
+        } else if (g_playback.repeat_mode == 2) {
+            g_track_origin_ns = track_end;
+            printf("\n⟳ Looping song\n");
+        } else if (g_playback.current->next && g_playback.current->next->song) {
+            set_current_track_at(g_playback.current->next, track_end);
+
+            if (g_playback.current == g_playback.head) {
+                printf("\n🔄 Playlist wrapped to beginning\n");
             }
-            next_requested = 0;
+
+            printf("▶ Now playing: %s\n", g_playback.current->song->title);
+        } else {
+            break;
         }
+    }
 
-        if (prev_requested) {
-            if (g_playback.head && g_playback.current) {
-                PlaylistNode *prev = g_playback.head;
-                while (prev->next != g_playback.current) prev = prev->next;
-                g_playback.current = prev;
-                g_playback.elapsed_seconds = 0;
-                if (g_playback.current->song) {
-                    g_playback.total_seconds = (int)length_to_seconds(&g_playback.current->song->length);
-                    printf("\n");
-                }
-            }
-            prev_requested = 0;
+    g_playback.elapsed_seconds = (int)((now - g_track_origin_ns) / NS_PER_SEC);
+}
+
+/* Arms the timer for the next whole second of the current track, or disarms
+ * it while the clock is stopped. */
+static void player_arm_timer() {
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if (g_clock_running) {
+        int64_t deadline = g_track_origin_ns + (int64_t)(g_playback.elapsed_seconds + 1) * NS_PER_SEC;
+        spec.it_value.tv_sec = deadline / NS_PER_SEC;
+        spec.it_value.tv_nsec = deadline % NS_PER_SEC;
+    }
+    timerfd_settime(g_player_timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+}
+
+static void* playback_loop(void *arg) {
+    (void)arg;
+    int running = 1;
+    struct pollfd fds[2] = {
+        { g_player_event_fd, POLLIN, 0 },
+        { g_player_timer_fd, POLLIN, 0 }
+    };
+
+    while (running) {
+        uint64_t count;
+        int timer_fired = 0;
+        if (fds[0].revents & POLLIN) {
+            ssize_t n = read(g_player_event_fd, &count, sizeof(count));
+            (void)n;
+        }
+        if (fds[1].revents & POLLIN) {
+            timer_fired = read(g_player_timer_fd, &count, sizeof(count)) > 0;
         }
 
-        if (g_playback.is_playing && !g_playback.is_paused && g_playback.current) {
-            if (!g_playback.current->song) {
-                if (g_playback.current->next != g_playback.current) {
-                    g_playback.current = g_playback.current->next;
-                    g_playback.elapsed_seconds = 0;
-                    if (g_playback.current->song) {
-                        g_playback.total_seconds = (int)length_to_seconds(&g_playback.current->song->length);
-                    }
-                }
-            }
+        pthread_mutex_lock(&g_playback_lock);
 
-            g_playback.elapsed_seconds++;
+        int64_t now = monotonic_ns();
+        int changed = clock_sync(now);
+        PlayerCommand cmd;
+        while (running && player_receive(&cmd)) {
+            running = player_apply(cmd);
+            changed = 1;
+            clock_sync(now);
+        }
 
-            if (g_playback.elapsed_seconds >= g_playback.total_seconds) {
-                if (g_playback.repeat_mode == 1) {
-                    g_playback.elapsed_seconds = 0;
-                    g_playback.repeat_mode = 0;
-                    printf("\n⟲ Repeating song once\n");
-                } else if (g_playback.repeat_mode == 2) {
-                    g_playback.elapsed_seconds = 0;
-                    printf("\n⟳ Looping song\n");
-                } else {
-                    if (g_playback.current->next && g_playback.current->next->song) {
-                        g_playback.current = g_playback.current->next;
-                        g_playback.elapsed_seconds = 0;
-                        g_playback.total_seconds = (int)length_to_seconds(&g_playback.current->song->length);
+        if (running) {
+            player_tick(now);
+            player_arm_timer();
+            if (g_playback.is_playing && (changed || timer_fired)) display_progress_bar();
+        }
 
-                        if (g_playback.current == g_playback.head) {
-                            printf("\n🔄 Playlist wrapped to beginning\n");
-                        }
+        pthread_mutex_unlock(&g_playback_lock);
 
-                        printf("▶ Now playing: %s\n", g_playback.current->song->title);
-                    }
-                }
+        while (running && poll(fds, 2, -1) < 0) {
+            if (errno != EINTR) {
+                perror("Playback poll failed");
+                running = 0;
             }
         }
+    }
+    return NULL;
+}
 
-        display_progress_bar();
-        sleep(1);
+/* Marks the playlist as playing and makes sure the player thread is up.
+ * Called with g_playback_lock held. */
+static void start_playback_locked() {
+    if (!g_playback.is_playing && g_playback.current) {
+        g_playback.is_playing = 1;
+        g_playback.is_paused = 0;
+        set_current_track(g_playback.current);
     }
+    start_playback_thread();
 }
 
-void start_playback_process() {
-    if (g_playback.playback_pid > 0) return;
+static void close_player_fds() {
+    if (g_player_event_fd >= 0) close(g_player_event_fd);
+    if (g_player_timer_fd >= 0) close(g_player_timer_fd);
+    g_player_event_fd = -1;
+    g_player_timer_fd = -1;
+}
 
-    pid_t pid = fork();
+void start_playback_thread() {
+    if (g_player_started) return;
 
-    if (pid < 0) { perror("fork failed"); return; }
+    g_player_event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    g_player_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (g_player_event_fd < 0 || g_player_timer_fd < 0) {
+        perror("Failed to create playback timer");
+        close_player_fds();
+        return;
+    }
 
-    if (pid == 0) {
-        playback_loop();
-        exit(0);
-    } else {
-        g_playback.playback_pid = pid;
+    if (pthread_create(&g_player_thread, NULL, playback_loop, NULL) != 0) {
+        perror("Failed to start playback thread");
+        close_player_fds();
+        return;
     }
+    g_player_started = 1;
 }
 
-void stop_playback_process() {
-    if (g_playback.playback_pid > 0) {
-        kill(g_playback.playback_pid, SIGKILL);
-        waitpid(g_playback.playback_pid, NULL, 0);
-        g_playback.playback_pid = -1;
-    }
+void stop_playback_thread() {
+    if (!g_player_started) return;
+
+    while (player_send(PLAYER_QUIT) != 0) sched_yield();
+    pthread_join(g_player_thread, NULL);
+    close_player_fds();
+    g_player_started = 0;
 }
 
 void listPlaylist() {
     printf("\nPLAYLIST\n\n");
 
+    playback_lock();
     if (!g_playback.head) {
+        playback_unlock();
         printf("Playlist is empty.\n");
         return;
     }
@@ -534,6 +1289,7 @@ void listPlaylist() {
         node = node->next;
         idx++;
     } while (node != start);
+    playback_unlock();
 }
 
 void handleListPlaylist(Command *cmd) {
@@ -595,28 +1351,11 @@ void nextSongs(const char *songs[], int count) {
             curr = next;
         }
 
-        int was_playing = g_playback.is_playing;
-
-        if (g_playback.playback_pid > 0) {
-            kill(g_playback.playback_pid, SIGKILL);
-            waitpid(g_playback.playback_pid, NULL, 0);
-            g_playback.playback_pid = -1;
-        }
-
+        playback_lock();
         playlist_insert_after_current(found_songs, found_count);
         make_playlist_circular();
-
-        if (was_playing || !g_playback.is_playing) {
-            g_playback.is_playing = 1;
-            g_playback.is_paused = 0;
-
-            if (g_playback.current && g_playback.current->song) {
-                g_playback.total_seconds = (int)length_to_seconds(&g_playback.current->song->length);
-                g_playback.elapsed_seconds = 0;
-            }
-
-            start_playback_process();
-        }
+        start_playback_locked();
+        playback_unlock();
 
         free(found_songs);
     }
@@ -652,31 +1391,20 @@ void nextAlbum(const char *albumname) {
         return;
     }
 
-    int count = 0;
-    for (AlbumNode *n = album->head; n; n = n->next) count++;
+    int count = album->track_count;
 
     if (count == 0) {
         printf("Album '%s' is empty.\n", albumname);
         return;
     }
 
-    Song **songs = malloc(count * sizeof(Song*));
-    if (!songs) return;
-    int idx = 0;
-    for (AlbumNode *n = album->head; n; n = n->next) songs[idx++] = n->song;
-
-    playlist_insert_after_current(songs, count);
+    playback_lock();
+    playlist_insert_after_current(album->tracks, count);
     make_playlist_circular();
-    free(songs);
+    start_playback_locked();
+    playback_unlock();
 
     printf("Added %d songs from album '%s' to playlist.\n", count, albumname);
-
-    if (!g_playback.is_playing && g_playback.current) {
-        g_playback.is_playing = 1;
-        g_playback.total_seconds = (int)length_to_seconds(&g_playback.current->song->length);
-        g_playback.elapsed_seconds = 0;
-        start_playback_process();
-    }
 }
 
 void handleNextAlbum(Command *cmd) {
@@ -688,54 +1416,68 @@ void handleNextAlbum(Command *cmd) {
 }
 
 void pausePlayback() {
-    if (!g_playback.is_playing) { printf("\nNo song is currently playing.\n"); return; }
-    if (g_playback.is_paused) { printf("\nPlayback is already paused.\n"); return; }
-    if (g_playback.playback_pid > 0) kill(g_playback.playback_pid, SIGUSR1);
-    g_playback.is_paused = 1;
+    playback_lock();
+    int is_playing = g_playback.is_playing, is_paused = g_playback.is_paused;
+    playback_unlock();
+    if (!is_playing) { printf("\nNo song is currently playing.\n"); return; }
+    if (is_paused) { printf("\nPlayback is already paused.\n"); return; }
+    player_send(PLAYER_PAUSE);
     printf("\nPaused.\n");
 }
 void handlePause(Command *cmd) { if (cmd->count != 1) { printf("Error! Invalid command format.\n"); return; } pausePlayback(); }
 
 void resumePlayback() {
-    if (!g_playback.is_playing) { printf("\nNo song to resume.\n"); return; }
-    if (!g_playback.is_paused) { printf("\nPlayback is not paused.\n"); return; }
-    if (g_playback.playback_pid > 0) kill(g_playback.playback_pid, SIGUSR2);
-    g_playback.is_paused = 0;
+    playback_lock();
+    int is_playing = g_playback.is_playing, is_paused = g_playback.is_paused;
+    playback_unlock();
+    if (!is_playing) { printf("\nNo song to resume.\n"); return; }
+    if (!is_paused) { printf("\nPlayback is not paused.\n"); return; }
+    player_send(PLAYER_RESUME);
     printf("\nResumed.\n");
 }
 void handleResume(Command *cmd) { if (cmd->count != 1) { printf("Error! Invalid command format.\n"); return; } resumePlayback(); }
 
 void fwd() {
-    if (!g_playback.head) { printf("\nPlaylist is empty.\n"); return; }
-    if (g_playback.playback_pid > 0) kill(g_playback.playback_pid, SIGCONT);
+    playback_lock();
+    int has_playlist = g_playback.head != NULL;
+    playback_unlock();
+    if (!has_playlist) { printf("\nPlaylist is empty.\n"); return; }
+    player_send(PLAYER_NEXT);
     printf("\nSkipped to next song.\n");
 }
 void handleFwd(Command *cmd) { if (cmd->count != 1) { printf("Error! Invalid command format.\n"); return; } fwd(); }
 
 void prev() {
-    if (!g_playback.head) { printf("\nPlaylist is empty.\n"); return; }
-    if (g_playback.playback_pid > 0) kill(g_playback.playback_pid, SIGTERM);
+    playback_lock();
+    int has_playlist = g_playback.head != NULL;
+    playback_unlock();
+    if (!has_playlist) { printf("\nPlaylist is empty.\n"); return; }
+    player_send(PLAYER_PREV);
     printf("\nWent back to previous song.\n");
 }
 void handlePrev(Command *cmd) { if (cmd->count != 1) { printf("Error! Invalid command format.\n"); return; } prev(); }
 
 void repeat() {
-    if (!g_playback.current || !g_playback.current->song) { printf("\nNo song is currently playing.\n"); return; }
-    if (g_playback.playback_pid > 0) kill(g_playback.playback_pid, SIGURG);
+    playback_lock();
+    int has_song = g_playback.current && g_playback.current->song;
+    playback_unlock();
+    if (!has_song) { printf("\nNo song is currently playing.\n"); return; }
+    player_send(PLAYER_REPEAT);
 }
 void handleRepeat(Command *cmd) { if (cmd->count != 1) { printf("Error! Invalid command format.\n"); return; } repeat(); }
 
 void shuffle() {
-    if (!g_playback.head) { printf("\nPlaylist is empty.\n"); return; }
+    playback_lock();
+    if (!g_playback.head) { playback_unlock(); printf("\nPlaylist is empty.\n"); return; }
 
     int count = 0;
     PlaylistNode *node = g_playback.head;
     do { count++; node = node->next; } while (node != g_playback.head);
 
-    if (count < 2) { printf("\nNeed at least 2 songs to shuffle.\n"); return; }
+    if (count < 2) { playback_unlock(); printf("\nNeed at least 2 songs to shuffle.\n"); return; }
 
     Song **songs = malloc(count * sizeof(Song*));
-    if (!songs) return;
+    if (!songs) { playback_unlock(); return; }
     node = g_playback.head;
     for (int i = 0; i < count; i++) { songs[i] = node->song; node = node->next; }
 
@@ -752,6 +1494,7 @@ void shuffle() {
         node->song = songs[i];
         node = node->next;
     }
+    playback_unlock();
 
     free(songs);
     printf("\nPlaylist shuffled (%d songs).\n", count);
@@ -760,63 +1503,62 @@ void handleShuffle(Command *cmd) { if (cmd->count != 1) { printf("Error! Invalid
 
 void removeSong(const char *songname) {
     if (!songname) { printf("\nNo song specified.\n"); return; }
-    if (!g_playback.head) { printf("\nPlaylist is empty.\n"); return; }
 
-    if (g_playback.playback_pid > 0) {
-        kill(g_playback.playback_pid, SIGKILL);
-        waitpid(g_playback.playback_pid, NULL, 0);
-        g_playback.playback_pid = -1;
+    char *folded_name = ascii_fold_dup(songname);
+    if (!folded_name) return;
+    size_t name_len = strlen(folded_name);
+
+    playback_lock();
+    if (!g_playback.head) {
+        playback_unlock();
+        free(folded_name);
+        printf("\nPlaylist is empty.\n");
+        return;
     }
 
-    PlaylistNode *prev = NULL;
     PlaylistNode *curr = g_playback.head;
     PlaylistNode *start = g_playback.head;
     int found = 0;
 
     do {
-        if (curr->song && curr->song->title && strcasecmp(curr->song->title, songname) == 0) {
+        if (curr->song && curr->song->title && strlen(curr->song->title) == name_len &&
+            ascii_equals_folded(curr->song->title, name_len, folded_name)) {
             found = 1;
             break;
         }
-        prev = curr;
         curr = curr->next;
     } while (curr != start);
+    free(folded_name);
 
     if (!found) {
+        playback_unlock();
         printf("\nSong '%s' not found in playlist.\n", songname);
-        if (g_playback.is_playing) start_playback_process();
         return;
     }
 
-    int was_playing = g_playback.is_playing;
-
     if (curr == g_playback.head && curr->next == g_playback.head) {
-        free(curr);
+        pool_free(&g_playlist_node_pool, curr);
         g_playback.head = NULL;
         g_playback.current = NULL;
         g_playback.is_playing = 0;
     } else {
-        if (curr == g_playback.current) {
-            g_playback.current = curr->next;
-            g_playback.elapsed_seconds = 0;
-            if (g_playback.current->song) g_playback.total_seconds = (int)length_to_seconds(&g_playback.current->song->length);
-        }
+        if (curr == g_playback.current) set_current_track(curr->next);
         if (curr == g_playback.head) g_playback.head = curr->next;
-        prev->next = curr->next;
-        free(curr);
+        curr->prev->next = curr->next;
+        curr->next->prev = curr->prev;
+        pool_free(&g_playlist_node_pool, curr);
     }
+    playback_unlock();
 
     printf("\nRemoved '%s' from playlist.\n", songname);
-
-    if (was_playing && g_playback.head) {
-        g_playback.is_playing = 1;
-        start_playback_process();
-    }
 }
 void handleRemove(Command *cmd) { if (cmd->count != 2) { printf("Error! Invalid command format.\n"); return; } removeSong(cmd->tokens[1]); }
 
 void loop() {
-    if (!g_playback.current || !g_playback.current->song) { printf("\nNo song is currently playing.\n"); return; }
-    if (g_playback.playback_pid > 0) kill(g_playback.playback_pid, SIGIO);
+    playback_lock();
+    int has_song = g_playback.current && g_playback.current->song;
+    playback_unlock();
+    if (!has_song) { printf("\nNo song is currently playing.\n"); return; }
+    player_send(PLAYER_LOOP);
 }
 void handleLoop(Command *cmd) { if (cmd->count != 1) { printf("Error! Invalid command format.\n"); return; } loop(); }
@@ -0,0 +1,235 @@
+#include <stdlib.h>
+#include <string.h>
+#include "include/textmatch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TEXTMATCH_X86 1
+#endif
+
+typedef struct TextKernels {
+    const char *name;
+    void (*fold)(char *dst, const char *src, size_t n);
+    int (*eq_folded)(const char *s, const char *folded, size_t n);
+    int (*eq_raw)(const char *a, const char *b, size_t n);
+    long (*find_byte2)(const char *s, size_t n, char c1, char c2);
+} TextKernels;
+
+static inline unsigned char fold_byte(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c + 32) : c;
+}
+
+static void fold_scalar(char *dst, const char *src, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = (char)fold_byte((unsigned char)src[i]);
+}
+
+static int eq_folded_scalar(const char *s, const char *folded, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (fold_byte((unsigned char)s[i]) != (unsigned char)folded[i]) return 0;
+    }
+    return 1;
+}
+
+static int eq_raw_scalar(const char *a, const char *b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (fold_byte((unsigned char)a[i]) != fold_byte((unsigned char)b[i])) return 0;
+    }
+    return 1;
+}
+
+static long find_byte2_scalar(const char *s, size_t n, char c1, char c2) {
+    for (size_t i = 0; i < n; i++) {
+        if (s[i] == c1 || s[i] == c2) return (long)i;
+    }
+    return -1;
+}
+
+static const TextKernels g_scalar_kernels = {
+    "scalar", fold_scalar, eq_folded_scalar, eq_raw_scalar, find_byte2_scalar
+};
+
+#ifdef TEXTMATCH_X86
+
+/* Lower-case 'A'..'Z' in a vector; bytes >= 0x80 are negative as signed and
+ * so never fall in the range. */
+__attribute__((target("sse2")))
+static inline __m128i fold_sse2(__m128i v) {
+    __m128i ge_a = _mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1));
+    __m128i le_z = _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), v);
+    __m128i upper = _mm_and_si128(ge_a, le_z);
+    return _mm_add_epi8(v, _mm_and_si128(upper, _mm_set1_epi8(32)));
+}
+
+__attribute__((target("sse2")))
+static void fold_sse2_impl(char *dst, const char *src, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), fold_sse2(v));
+    }
+    fold_scalar(dst + i, src + i, n - i);
+}
+
+__attribute__((target("sse2")))
+static int eq_folded_sse2(const char *s, const char *folded, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = fold_sse2(_mm_loadu_si128((const __m128i *)(s + i)));
+        __m128i b = _mm_loadu_si128((const __m128i *)(folded + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF) return 0;
+    }
+    return eq_folded_scalar(s + i, folded + i, n - i);
+}
+
+__attribute__((target("sse2")))
+static int eq_raw_sse2(const char *x, const char *y, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = fold_sse2(_mm_loadu_si128((const __m128i *)(x + i)));
+        __m128i b = fold_sse2(_mm_loadu_si128((const __m128i *)(y + i)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF) return 0;
+    }
+    return eq_raw_scalar(x + i, y + i, n - i);
+}
+
+__attribute__((target("sse2")))
+static long find_byte2_sse2(const char *s, size_t n, char c1, char c2) {
+    __m128i v1 = _mm_set1_epi8(c1);
+    __m128i v2 = _mm_set1_epi8(c2);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, v1), _mm_cmpeq_epi8(v, v2)));
+        if (mask) return (long)(i + __builtin_ctz(mask));
+    }
+    long rest = find_byte2_scalar(s + i, n - i, c1, c2);
+    return rest < 0 ? -1 : (long)i + rest;
+}
+
+static const TextKernels g_sse2_kernels = {
+    "sse2", fold_sse2_impl, eq_folded_sse2, eq_raw_sse2, find_byte2_sse2
+};
+
+__attribute__((target("avx2")))
+static inline __m256i fold_avx2(__m256i v) {
+    __m256i ge_a = _mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1));
+    __m256i le_z = _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v);
+    __m256i upper = _mm256_and_si256(ge_a, le_z);
+    return _mm256_add_epi8(v, _mm256_and_si256(upper, _mm256_set1_epi8(32)));
+}
+
+__attribute__((target("avx2")))
+static void fold_avx2_impl(char *dst, const char *src, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), fold_avx2(v));
+    }
+    fold_sse2_impl(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static int eq_folded_avx2(const char *s, const char *folded, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i a = fold_avx2(_mm256_loadu_si256((const __m256i *)(s + i)));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(folded + i));
+        if ((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) != 0xFFFFFFFFu) return 0;
+    }
+    return eq_folded_sse2(s + i, folded + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static int eq_raw_avx2(const char *x, const char *y, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i a = fold_avx2(_mm256_loadu_si256((const __m256i *)(x + i)));
+        __m256i b = fold_avx2(_mm256_loadu_si256((const __m256i *)(y + i)));
+        if ((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) != 0xFFFFFFFFu) return 0;
+    }
+    return eq_raw_sse2(x + i, y + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static long find_byte2_avx2(const char *s, size_t n, char c1, char c2) {
+    __m256i v1 = _mm256_set1_epi8(c1);
+    __m256i v2 = _mm256_set1_epi8(c2);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, v1), _mm256_cmpeq_epi8(v, v2)));
+        if (mask) return (long)(i + __builtin_ctz(mask));
+    }
+    long rest = find_byte2_sse2(s + i, n - i, c1, c2);
+    return rest < 0 ? -1 : (long)i + rest;
+}
+
+static const TextKernels g_avx2_kernels = {
+    "avx2", fold_avx2_impl, eq_folded_avx2, eq_raw_avx2, find_byte2_avx2
+};
+
+#endif
+
+static const TextKernels *g_kernels = NULL;
+
+static const TextKernels* kernels() {
+    if (!g_kernels) {
+        g_kernels = &g_scalar_kernels;
+#ifdef TEXTMATCH_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) g_kernels = &g_avx2_kernels;
+        else if (__builtin_cpu_supports("sse2")) g_kernels = &g_sse2_kernels;
+#endif
+    }
+    return g_kernels;
+}
+
+const char* textmatch_impl_name() {
+    return kernels()->name;
+}
+
+void ascii_fold(char *dst, const char *src, size_t n) {
+    kernels()->fold(dst, src, n);
+}
+
+char* ascii_fold_dup(const char *src) {
+    if (!src) return NULL;
+    size_t n = strlen(src);
+    char *out = malloc(n + 1);
+    if (!out) return NULL;
+    kernels()->fold(out, src, n);
+    out[n] = '\0';
+    return out;
+}
+
+int ascii_casecmp_eq(const char *a, const char *b) {
+    if (!a || !b) return 0;
+    size_t n = strlen(a);
+    if (strlen(b) != n) return 0;
+    return kernels()->eq_raw(a, b, n);
+}
+
+int ascii_equals_folded(const char *s, size_t n, const char *folded) {
+    return kernels()->eq_folded(s, folded, n);
+}
+
+long ascii_find_folded(const char *haystack, size_t hay_len, const char *needle_folded, size_t needle_len) {
+    if (needle_len == 0) return 0;
+    if (needle_len > hay_len) return -1;
+
+    const TextKernels *k = kernels();
+    char first = needle_folded[0];
+    char first_upper = (first >= 'a' && first <= 'z') ? (char)(first - 32) : first;
+    size_t last_start = hay_len - needle_len;
+    size_t pos = 0;
+
+    while (pos <= last_start) {
+        long hit = k->find_byte2(haystack + pos, last_start - pos + 1, first, first_upper);
+        if (hit < 0) return -1;
+        pos += (size_t)hit;
+        if (k->eq_folded(haystack + pos + 1, needle_folded + 1, needle_len - 1)) return (long)pos;
+        pos++;
+    }
+    return -1;
+}
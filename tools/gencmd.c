@@ -0,0 +1,129 @@
+/* Build-time generator for include/cmd_dispatch.h.
+ *
+ * Reads the command table from include/commands.def, splits every full name
+ * into its words and searches for a hash seed under which all names land in
+ * distinct slots of a power-of-two table. The output lets dispatchCommand
+ * find a command with at most three hash probes and no string copies. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/cmd_hash.h"
+
+#define MAX_WORDS 3
+#define MAX_WORD_LEN 32
+
+typedef struct GenCommand {
+    const char *full_name;
+    int command_words;
+} GenCommand;
+
+#define COMMAND(name, full_name, words, min_args, max_args, handler) { full_name, words },
+static const GenCommand g_commands[] = {
+#include "../include/commands.def"
+};
+#undef COMMAND
+
+#define COMMAND_COUNT ((int)(sizeof(g_commands) / sizeof(g_commands[0])))
+
+static char g_words[COMMAND_COUNT][MAX_WORDS][MAX_WORD_LEN];
+
+static int split_names() {
+    for (int i = 0; i < COMMAND_COUNT; i++) {
+        const char *p = g_commands[i].full_name;
+        int n = 0;
+        while (*p) {
+            while (*p == ' ') p++;
+            if (!*p) break;
+            if (n == MAX_WORDS) {
+                fprintf(stderr, "gencmd: '%s' has more than %d words\n", g_commands[i].full_name, MAX_WORDS);
+                return -1;
+            }
+            size_t len = strcspn(p, " ");
+            if (len >= MAX_WORD_LEN) {
+                fprintf(stderr, "gencmd: word too long in '%s'\n", g_commands[i].full_name);
+                return -1;
+            }
+            memcpy(g_words[i][n], p, len);
+            g_words[i][n][len] = '\0';
+            n++;
+            p += len;
+        }
+        if (n != g_commands[i].command_words) {
+            fprintf(stderr, "gencmd: '%s' declares %d words but has %d\n",
+                    g_commands[i].full_name, g_commands[i].command_words, n);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static uint32_t hash_command(int i, uint32_t seed) {
+    uint32_t h = cmd_hash_begin(seed);
+    for (int w = 0; w < g_commands[i].command_words; w++) h = cmd_hash_word(h, g_words[i][w], w == 0);
+    return cmd_hash_end(h);
+}
+
+/* Fills slots for the given seed; returns 0 when there are no collisions. */
+static int try_seed(uint32_t seed, int *slots, int size) {
+    for (int s = 0; s < size; s++) slots[s] = -1;
+    for (int i = 0; i < COMMAND_COUNT; i++) {
+        int s = (int)(hash_command(i, seed) & (uint32_t)(size - 1));
+        if (slots[s] >= 0) {
+            if (strcmp(g_commands[slots[s]].full_name, g_commands[i].full_name) == 0) {
+                fprintf(stderr, "gencmd: duplicate command '%s'\n", g_commands[i].full_name);
+                exit(1);
+            }
+            return -1;
+        }
+        slots[s] = i;
+    }
+    return 0;
+}
+
+int main() {
+    if (split_names() != 0) return 1;
+
+    int size = 1;
+    while (size < COMMAND_COUNT * 2) size *= 2;
+
+    int *slots = NULL;
+    uint32_t seed = 0;
+    for (;;) {
+        slots = realloc(slots, size * sizeof(int));
+        if (!slots) return 1;
+        for (seed = 0; seed < 1000000; seed++) {
+            if (try_seed(seed, slots, size) == 0) break;
+        }
+        if (seed < 1000000) break;
+        size *= 2;
+    }
+
+    printf("/* Generated by tools/gencmd from include/commands.def. Do not edit. */\n");
+    printf("#ifndef CMD_DISPATCH_H\n#define CMD_DISPATCH_H\n\n");
+    printf("#include \"cmd_hash.h\"\n\n");
+    printf("#define CMD_COUNT %d\n", COMMAND_COUNT);
+    printf("#define CMD_MAX_WORDS %d\n", MAX_WORDS);
+    printf("#define CMD_HASH_SEED 0x%08xu\n", seed);
+    printf("#define CMD_HASH_MASK %du\n\n", size - 1);
+
+    printf("/* Slot -> index into commands[], or -1. */\n");
+    printf("static const short cmd_hash_slots[%d] = {", size);
+    for (int s = 0; s < size; s++) printf("%s%s%d", s ? "," : "", s % 16 ? " " : "\n    ", slots[s]);
+    printf("\n};\n\n");
+
+    printf("/* Words of each command's full name. */\n");
+    printf("static const char *const cmd_words[CMD_COUNT][CMD_MAX_WORDS] = {\n");
+    for (int i = 0; i < COMMAND_COUNT; i++) {
+        printf("    {");
+        for (int w = 0; w < MAX_WORDS; w++) {
+            if (w) printf(", ");
+            if (w < g_commands[i].command_words) printf("\"%s\"", g_words[i][w]);
+            else printf("NULL");
+        }
+        printf("},\n");
+    }
+    printf("};\n\n#endif\n");
+
+    free(slots);
+    return 0;
+}
@@ -2,16 +2,28 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
 #include "include/utils.h"
 #include "include/songs.h"
 #include "include/albums.h"
+#include "include/arena.h"
+#include "include/catalog.h"
+#include "include/search.h"
+#include "include/textmatch.h"
+#include "include/logger.h"
+#include "include/import.h"
+#include "include/persist.h"
+#include "include/cmd_dispatch.h"
 #include <sys/wait.h>
 #include <unistd.h>
 #include <signal.h>
+#include <time.h>
+#include <errno.h>
 
+// Split line into tokens in place: each token is NUL-terminated inside line
+// and cmd.tokens points at it, so line must outlive the command.
 Command parseCommand(char *line) {
     Command cmd;
-    cmd.tokens = (char**)malloc(MAX_TOKENS * sizeof(char*));
     cmd.count = 0;
     
     char *ptr = line;
@@ -23,66 +35,38 @@ Command parseCommand(char *line) {
         
         if (*ptr == '"') {
             ptr++;
-            char *start = ptr;
+            cmd.tokens[cmd.count++] = ptr;
             
             while (*ptr && *ptr != '"') ptr++;
             
-            int len = ptr - start;
-            cmd.tokens[cmd.count] = (char*)malloc(len + 1);
-            strncpy(cmd.tokens[cmd.count], start, len);
-            cmd.tokens[cmd.count][len] = '\0';
-            cmd.count++;
-            
-            if (*ptr == '"') ptr++;
+            if (*ptr == '"') *ptr++ = '\0';
         } else {
-            char *start = ptr;
+            cmd.tokens[cmd.count++] = ptr;
             while (*ptr && *ptr != ' ' && *ptr != '\t' && *ptr != '\n') ptr++;
             
-            int len = ptr - start;
-            cmd.tokens[cmd.count] = (char*)malloc(len + 1);
-            strncpy(cmd.tokens[cmd.count], start, len);
-            cmd.tokens[cmd.count][len] = '\0';
-            cmd.count++;
+            if (*ptr) *ptr++ = '\0';
         }
     }
     
     return cmd;
 }
 
+// Tokens live in the parsed line, so there is nothing to release.
 void freeCommand(Command *cmd) {
-    for (int i = 0; i < cmd->count; i++) {
-        free(cmd->tokens[i]);
-    }
-    free(cmd->tokens);
+    (void)cmd;
 } 
 
+#define COMMAND(name, full_name, words, min_args, max_args, handler) \
+    {name, full_name, words, min_args, max_args, handler},
 CommandDef commands[] = {
-    {"HELP", "HELP", 1, 1, 1, handleHelp},
-    {"LOAD", "LOAD", 1, 1, 1, handleLoad},
-    {"LIST", "LIST SONGS", 2, 2, 2, handleListSongs},
-    {"LIST", "LIST ALBUMS", 2, 2, 2, handleListAlbums},
-    {"LIST", "LIST IN ALBUM", 3, 4, 4, handleListSongsInAlbum},
-    {"LIST", "LIST PLAYLIST", 2, 2, 2, handleListPlaylist},
-    {"CREATE", "CREATE", 1, 2, -1, handleCreateAlbum},
-    {"MANAGE", "MANAGE ADD", 2, 4, 4, handleManageAddSong},
-    {"MANAGE", "MANAGE SWAP", 2, 5, 5, handleManageSwapSongs},
-    {"MANAGE", "MANAGE MOVE", 2, 5, 5, handleManageMoveSong},
-    {"MANAGE", "MANAGE DELETE", 2, 4, 4, handleManageDeleteSong},
-    {"DELETE", "DELETE ALBUM", 2, 3, 3, handleDeleteAlbum},
-    {"NEXT", "NEXT SONG",  2, 3, -1, handleNextSongs},
-    {"NEXT", "NEXT ALBUM", 2, 3, 3, handleNextAlbum},
-    {"PAUSE", "PAUSE", 1, 1, 1, handlePause},
-    {"RESUME", "RESUME", 1, 1, 1, handleResume},
-    {"FWD", "FWD", 1, 1, 1, handleFwd},
-    {"PREV", "PREV", 1, 1, 1, handlePrev},
-    {"REPEAT", "REPEAT", 1, 1, 1, handleRepeat},
-    {"SHUFFLE", "SHUFFLE", 1, 1, 1, handleShuffle},
-    {"REMOVE", "REMOVE", 1, 2, 2, handleRemove},
-    {"LOOP", "LOOP", 1, 1, 1, handleLoop},
-    {"LOG", "LOG", 1, 1, 1, handleLog},
-    {"EXIT", "EXIT", 1, 1, 1, handleExit},
+#include "include/commands.def"
     {NULL, NULL, 0, 0, 0, NULL}
 };
+#undef COMMAND
+
+// Set when commands come from a script rather than a terminal: no prompts
+// are shown and ambiguous names resolve to the first listed match.
+int g_batch_mode = 0;
 
 // Check if the input is a number
 int isNumericCommand(const char *str) {
@@ -95,70 +79,44 @@ int isNumericCommand(const char *str) {
 
 // Get command definition by number
 CommandDef* getCommandByNumber(int num) {
-    int count = 0;
-    for (int i = 0; commands[i].name != NULL; i++) {
-        count++;
-        if (count == num) {
-            return &commands[i];
-        }
-    }
-    return NULL;
+    if (num < 1 || num > CMD_COUNT) return NULL;
+    return &commands[num - 1];
 }
 
-// Convert command number to actual command tokens
-Command convertNumberToCommand(int cmdNum, Command *originalCmd) {
-    Command newCmd;
-    newCmd.tokens = (char**)malloc(MAX_TOKENS * sizeof(char*));
-    newCmd.count = 0;
+// Convert command number to actual command tokens. The command words point at
+// the generated constant word table and the arguments at the original tokens,
+// so nothing is copied.
+static CommandDef* convertNumberToCommand(int cmdNum, Command *originalCmd, Command *newCmd) {
+    newCmd->count = 0;
     
     CommandDef *def = getCommandByNumber(cmdNum);
     if (!def) {
         printf("\n✗ Invalid command number: %d\n", cmdNum);
-        printf("  Type 'HELP' to see valid command numbers (1-24).\n");
-        return newCmd;
+        printf("  Type 'HELP' to see valid command numbers (1-%d).\n", CMD_COUNT);
+        return NULL;
     }
     
-    // Parse the full command name and add tokens
-    char full_copy[256];
-    strncpy(full_copy, def->full_name, 255);
-    full_copy[255] = '\0';
-    
-    char *word = strtok(full_copy, " ");
-    while (word != NULL && newCmd.count < MAX_TOKENS) {
-        newCmd.tokens[newCmd.count] = strdup(word);
-        newCmd.count++;
-        word = strtok(NULL, " ");
+    const char *const *words = cmd_words[def - commands];
+    for (int i = 0; i < def->command_words; i++) {
+        newCmd->tokens[newCmd->count++] = (char*)words[i];
     }
     
     // Copy remaining arguments from original command (skip the number itself)
-    for (int i = 1; i < originalCmd->count && newCmd.count < MAX_TOKENS; i++) {
-        newCmd.tokens[newCmd.count] = strdup(originalCmd->tokens[i]);
-        newCmd.count++;
+    for (int i = 1; i < originalCmd->count && newCmd->count < MAX_TOKENS; i++) {
+        newCmd->tokens[newCmd->count++] = originalCmd->tokens[i];
     }
     
-    return newCmd;
+    return def;
 }
 
+// Check the command words and token count of cmd against def
 int matchCommand(Command *cmd, CommandDef *def) {
-    if (cmd->count == 0) return 0;
-    
-    if (strcmp(cmd->tokens[0], def->name) != 0) {
-        return 0;
-    }
+    if (cmd->count < def->command_words) return 0;
     
-    if (def->command_words > 1) {
-        if (cmd->count < def->command_words) return 0;
-        
-        char full_copy[256];
-        strncpy(full_copy, def->full_name, 255);
-        full_copy[255] = '\0';
-        
-        char *word = strtok(full_copy, " ");
-        for (int i = 0; i < def->command_words && word != NULL; i++) {
-            if (strcmp(cmd->tokens[i], word) != 0) {
-                return 0;
-            }
-            word = strtok(NULL, " ");
+    const char *const *words = cmd_words[def - commands];
+    for (int i = 0; i < def->command_words; i++) {
+        if (strcmp(cmd->tokens[i], words[i]) != 0) {
+            return 0;
         }
     }
     
@@ -175,34 +133,43 @@ int matchCommand(Command *cmd, CommandDef *def) {
     return 1;
 }
 
+// Look up the command named by the leading tokens, longest name first. Each
+// probe hashes the tokens in place and checks the one candidate slot.
+static CommandDef* lookupCommand(Command *cmd) {
+    int max_words = cmd->count < CMD_MAX_WORDS ? cmd->count : CMD_MAX_WORDS;
+    
+    for (int words = max_words; words >= 1; words--) {
+        uint32_t h = cmd_hash_begin(CMD_HASH_SEED);
+        for (int i = 0; i < words; i++) h = cmd_hash_word(h, cmd->tokens[i], i == 0);
+        
+        int idx = cmd_hash_slots[cmd_hash_end(h) & CMD_HASH_MASK];
+        if (idx < 0 || commands[idx].command_words != words) continue;
+        
+        const char *const *expected = cmd_words[idx];
+        int i = 0;
+        while (i < words && strcmp(cmd->tokens[i], expected[i]) == 0) i++;
+        if (i == words) return &commands[idx];
+    }
+    return NULL;
+}
+
 void dispatchCommand(Command *cmd) {
     if (cmd->count == 0) return;
     
     // Check if first token is a number
     if (isNumericCommand(cmd->tokens[0])) {
-        int cmdNum = atoi(cmd->tokens[0]);
-        Command newCmd = convertNumberToCommand(cmdNum, cmd);
+        Command newCmd;
         
-        if (newCmd.count > 0) {
-            // Dispatch the converted command
-            for (int i = 0; commands[i].name != NULL; i++) {
-                if (matchCommand(&newCmd, &commands[i])) {
-                    commands[i].handler(&newCmd);
-                    freeCommand(&newCmd);
-                    return;
-                }
-            }
-        }
-        freeCommand(&newCmd);
+        CommandDef *def = convertNumberToCommand(atoi(cmd->tokens[0]), cmd, &newCmd);
+        if (def && matchCommand(&newCmd, def)) def->handler(&newCmd);
         return;
     }
     
     // Normal command dispatch
-    for (int i = 0; commands[i].name != NULL; i++) {
-        if (matchCommand(cmd, &commands[i])) {
-            commands[i].handler(cmd);
-            return;
-        }
+    CommandDef *def = lookupCommand(cmd);
+    if (def && matchCommand(cmd, def)) {
+        def->handler(cmd);
+        return;
     }
     
     printf("\n✗ Unknown command: %s\n", cmd->tokens[0]);
@@ -235,8 +202,13 @@ void help() {
     printf("20. SHUFFLE - Shuffle playlist\n");
     printf("21. REMOVE <songname> - Remove song from playlist\n");
     printf("22. LOOP - Loop current song indefinitely\n");
-    printf("23. LOG - Display command history\n");
-    printf("24. EXIT - Exit the program\n\n");
+    printf("23. LOG [<page> | <from> <to> | TAIL] - Display command history\n");
+    printf("24. EXIT - Exit the program\n");
+    printf("25. STATS - Show memory allocator statistics\n");
+    printf("26. LIST YEAR <year> - List songs released in a year\n");
+    printf("27. SEARCH <text> - Find songs whose title or artist contains text\n");
+    printf("28. IMPORT <file> - Add songs from a CSV/TSV file (title, artist, length, year)\n");
+    printf("29. SAVE [BACKGROUND] - Write the library to disk, optionally in a background process\n\n");
 }
 
 void handleHelp(Command *cmd) {
@@ -269,17 +241,16 @@ void loadSong() {
     scanf("%d", &year);
     getchar();
     
-    Song *s = malloc(sizeof(Song));
-    if (song_init(s, title, artist, length_str, year) == 0) {
+    Song *s = song_alloc();
+    if (s && song_init(s, title, artist, length_str, year) == 0) {
         if (add_song_to_library(s) == 0) {
             printf("\n✓ Added: %s - %s\n", title, artist);
         } else {
-            song_free(s);
-            free(s);
+            song_release(s);
             printf("\n✗ Failed to add song to library\n");
         }
     } else {
-        free(s);
+        song_release(s);
         printf("\n✗ Invalid song format\n");
     }
 }
@@ -313,13 +284,11 @@ void playsong(const char *songname) {
         play_process_pid = -1;
     }
     
+    playback_lock();
     int was_playing = g_playback.is_playing;
-    if (g_playback.playback_pid > 0) {
-        kill(g_playback.playback_pid, SIGSTOP);
-    }
-    
     g_playback.is_playing = 0;
     g_playback.is_paused = 1;
+    playback_unlock();
     
     printf("\nPLAYING SINGLE SONG\n\n");
     printf("Title:  %s\n", s->title);
@@ -327,6 +296,7 @@ void playsong(const char *songname) {
     printf("Length: %02d:%02d:%02d\n", s->length.hh, s->length.mm, s->length.ss);
     printf("Year:   %d\n\n", s->year);
     
+    fflush(stdout);
     pid_t pid = fork();
     
     if (pid < 0) {
@@ -336,6 +306,8 @@ void playsong(const char *songname) {
     
     if (pid == 0) {
         int total_seconds = length_to_seconds(&s->length);
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
         for (int i = 0; i <= total_seconds; i++) {
             printf("\r\033[K");
             printf("⏸ [");
@@ -349,7 +321,10 @@ void playsong(const char *songname) {
                    i / 3600, (i % 3600) / 60, i % 60,
                    total_seconds / 3600, (total_seconds % 3600) / 60, total_seconds % 60);
             fflush(stdout);
-            sleep(1);
+            /* Absolute deadlines keep the bar in step with the wall clock
+             * however long each redraw takes. */
+            deadline.tv_sec++;
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {}
         }
         
         printf("\n\nSong finished.\n");
@@ -362,11 +337,10 @@ void playsong(const char *songname) {
         play_process_pid = -1;
         
         if (was_playing) {
+            playback_lock();
             g_playback.is_playing = 1;
             g_playback.is_paused = 0;
-            if (g_playback.playback_pid > 0) {
-                kill(g_playback.playback_pid, SIGCONT);
-            }
+            playback_unlock();
             printf("Resuming playlist...\n");
         }
     }
@@ -388,27 +362,60 @@ void listSongs() {
         return;
     }
 
-    Song *current = g_songs;
     int number = 1;
+    for (int row = g_catalog.count - 1; row >= 0; row--, number++) {
+        int secs = g_catalog.seconds[row];
+        printf("%d. %s - %s (%02d:%02d:%02d, %d)\n",
+               number,
+               g_catalog.titles[row],
+               g_catalog.artists[row],
+               secs / 3600, (secs % 3600) / 60, secs % 60,
+               g_catalog.years[row]);
+    }
 
-    while (current) {
-        char lenbuf[32];
-        format_length(&current->length, lenbuf, sizeof(lenbuf));
+    long total = catalog_total_seconds();
+    printf("\nTotal: %d songs, %02ld:%02ld:%02ld\n\n",
+           g_catalog.count, total / 3600, (total % 3600) / 60, total % 60);
+}
 
-        printf("%d. %s - %s (%s, %d)\n",
-               number,
-               current->title,
-               current->artist,
-               lenbuf,
-               current->year);
 
-        current = current->next;
-        number++;
+void listSongsByYear(int year) {
+    printf("\nSONGS FROM %d:\n", year);
+
+    int *rows = malloc((g_catalog.count ? g_catalog.count : 1) * sizeof(int));
+    if (!rows) return;
+    int matched = catalog_rows_for_year(year, rows);
+    if (matched == 0) {
+        printf("No songs found.\n\n");
+        free(rows);
+        return;
     }
 
-    printf("\n");
+    long total = 0;
+    for (int i = matched - 1; i >= 0; i--) {
+        int row = rows[i];
+        int secs = g_catalog.seconds[row];
+        total += secs;
+        printf("%d. %s - %s (%02d:%02d:%02d)\n",
+               g_catalog.count - row,
+               g_catalog.titles[row],
+               g_catalog.artists[row],
+               secs / 3600, (secs % 3600) / 60, secs % 60);
+    }
+    free(rows);
+
+    printf("\nTotal: %d songs, %02ld:%02ld:%02ld\n\n",
+           matched, total / 3600, (total % 3600) / 60, total % 60);
 }
 
+void handleListYear(Command *cmd) {
+    if (cmd->count != 3 || !is_number(cmd->tokens[2])) {
+        printf("Error! Invalid command format.\n");
+        printf("Usage: LIST YEAR <year>\n");
+        return;
+    }
+    listSongsByYear(atoi(cmd->tokens[2]));
+}
 
 void handleListSongs(Command *cmd) {
     if (cmd->count != 2) {
@@ -418,46 +425,105 @@ void handleListSongs(Command *cmd) {
     listSongs();
 }
 
-void showLog() {
-    FILE *logFile = fopen("utils/command_log.txt", "r");
-    if (logFile != NULL) {
-        char line[MAX_LINE];
-        
-        printf("\nCOMMAND LOG\n\n");
-        
-        int count = 0;
-        while (fgets(line, sizeof(line), logFile)) {
-            count++;
-            printf("%d. %s", count, line);
-        }
-        fclose(logFile);
-        
-        if (count == 0) {
-            printf("No commands have been logged yet.\n");
-        }
-    } else {
+// Print log entries first..last, numbered from the start of the current log
+static void printLogEntries(long first, long last, long total) {
+    char *text;
+    size_t len;
+    if (log_read_entries(first, last, &text, &len) != 0) {
+        printf("Failed to read command log.\n");
+        return;
+    }
+    
+    printf("\nCOMMAND LOG (%ld-%ld of %ld)\n\n", first, last, total);
+    
+    long number = first;
+    char *line = text;
+    while (line < text + len) {
+        char *end = memchr(line, '\n', text + len - line);
+        int line_len = end ? (int)(end - line) : (int)(text + len - line);
+        printf("%ld. %.*s\n", number++, line_len, line);
+        if (!end) break;
+        line = end + 1;
+    }
+    free(text);
+}
+
+// Show entries from..to (1-based, inclusive), clamped to the log
+void showLog(long from, long to) {
+    long total = log_entry_count();
+    if (total == 0) {
         printf("No commands have been logged yet.\n");
+        return;
     }
+    
+    if (from < 1) from = 1;
+    if (to > total) to = total;
+    if (from > to) {
+        printf("\nThe log has %ld entries.\n", total);
+        return;
+    }
+    printLogEntries(from, to, total);
+}
+
+void showLogPage(long page) {
+    /* Any page this large is past the end of the log; clamping keeps the
+     * entry arithmetic from overflowing. */
+    if (page > LONG_MAX / LOG_PAGE_SIZE) page = LONG_MAX / LOG_PAGE_SIZE;
+    showLog((page - 1) * LOG_PAGE_SIZE + 1, page * LOG_PAGE_SIZE);
+}
+
+void showLogTail() {
+    long total = log_entry_count();
+    showLog(total - LOG_TAIL_SIZE + 1, total);
+}
+
+// Parse a positive log entry or page number
+static int parseLogNumber(const char *s, long *out) {
+    char *end;
+    long value = strtol(s, &end, 10);
+    if (*s == '\0' || *end != '\0' || value < 1) return -1;
+    *out = value;
+    return 0;
 }
 
 void handleLog(Command *cmd) {
+    long a, b;
+    if (cmd->count == 1) {
+        showLogPage(1);
+    } else if (cmd->count == 2 && strcmp(cmd->tokens[1], "TAIL") == 0) {
+        showLogTail();
+    } else if (cmd->count == 2 && parseLogNumber(cmd->tokens[1], &a) == 0) {
+        showLogPage(a);
+    } else if (cmd->count == 3 && parseLogNumber(cmd->tokens[1], &a) == 0 &&
+               parseLogNumber(cmd->tokens[2], &b) == 0 && a <= b) {
+        showLog(a, b);
+    } else {
+        printf("Error! Invalid command format.\n");
+        printf("Usage: LOG [<page> | <from> <to> | TAIL]\n");
+    }
+}
+
+void showStats() {
+    printf("\nALLOCATOR STATISTICS\n\n");
+    arena_print_stats();
+    printf("\nText matching kernels: %s\n\n", textmatch_impl_name());
+}
+
+void handleStats(Command *cmd) {
     if (cmd->count != 1) {
         printf("Error! Invalid command format.\n");
         return;
     }
-    showLog();
+    showStats();
 }
 
 void exitProgram() {
     printf("\nSaving and exiting...\n\n");
     
-    save_all_songs_to_bin();
-    
-    for (Album *a = g_albums; a; a = a->next) {
-        save_album_to_bin(a);
-    }
+    persist_flush_all();
     
     cleanup_playback_state();
+    log_shutdown();
     
     printf("Goodbye!\n");
     exit(0);
@@ -479,9 +545,6 @@ void stopPlay() {
         printf("\nStopped playback.\n");
         
         if (g_playback.is_playing) {
-            if (g_playback.playback_pid > 0) {
-                kill(g_playback.playback_pid, SIGCONT);
-            }
             printf("Resuming playlist...\n");
         }
     } else {